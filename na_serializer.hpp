@@ -1,11 +1,20 @@
 ﻿#pragma once
+#include <array>
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <new>
 #include <span>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
+#if defined(__SSE2__) || defined(__AVX2__)
+    #include <immintrin.h>
+#endif
 namespace na::serializer {
 #ifdef __INTELLISENSE__
     #define NA_SERIALIZER_HIDE_IMPL
@@ -134,6 +143,13 @@ struct node_path
 
     template<size_type I>
     requires(I <= size) using take_first_n = decltype(take_first_n_helper(::std::make_index_sequence<I>{}));
+
+    template<size_type I, typename T, T... Is>
+    inline static consteval auto drop_first_n_helper(std::integer_sequence<T, Is...>)
+        -> node_path<Root, at<I + Is>...>;
+
+    template<size_type I>
+    requires(I <= size) using drop_first_n = decltype(drop_first_n_helper<I>(::std::make_index_sequence<size - I>{}));
 };
 
 template<any_node_path Path>
@@ -219,6 +235,10 @@ struct node : node_base<S, Option, Profile, Path>
 
     // constexpr static bool postpend_fixed_size = ;
 
+    // 可选：deserialize_prepend/deserialize_postpend 什么都不做（例如头部已经整体校验过）时为 true，反序列化计划中省去对应的 step
+    // constexpr static bool deserialize_prepend_noop = ;
+    // constexpr static bool deserialize_postpend_noop = ;
+
     // constexpr static size_type prepend_minimal_size = ;
 
     // constexpr static size_type payload_minimal_size = ;
@@ -226,6 +246,10 @@ struct node : node_base<S, Option, Profile, Path>
     // constexpr static size_type postpend_minimal_size = ;
 
     // inline constexpr static auto& payload_reference(auto& value)
+    // value 也可以是 subtree_reference，此时从子树的根开始查找
+
+    // 可选：复合节点按成员指针给出子节点下标，供 lazy::get<&T::member> 使用
+    // template<auto Member> constexpr static size_type member_index = ;
 
     // using context = ;
 
@@ -234,6 +258,19 @@ struct node : node_base<S, Option, Profile, Path>
     // inline constexpr static bool deserialize_postpend(auto& value, ::std::byte const* start, ::std::size_t& offset, ::std::size_t reversed, auto& context, auto& error_code)
 
     // inline constexpr static bool deserialize_all(auto& value, ::std::byte const* start, ::std::size_t& offset, ::std::size_t reversed, auto& error_code)
+    // or: inline constexpr static bool deserialize_all(auto& value, ::std::byte const* start, ::std::size_t& offset, ::std::size_t reversed, auto& allocation, auto& error_code)
+
+    // 变长节点（payload 不定长的 primitive）需要：不构造对象跳过 payload，只更新 offset，供 lazy 定位其后的节点
+    // inline static bool deserialize_skip(::std::byte const* start, ::std::size_t& offset, ::std::size_t reversed, auto& error_code)
+
+    // using serialize_context = ;
+
+    // inline constexpr static bool serialize_prepend(auto const& value, ::std::byte* start, ::std::size_t base, ::std::size_t& offset, ::std::size_t reversed, auto& context, auto& error_code)
+
+    // inline constexpr static bool serialize_postpend(auto const& value, ::std::byte* start, ::std::size_t base, ::std::size_t& offset, ::std::size_t reversed, auto& context, auto& error_code)
+
+    // inline constexpr static bool serialize_all(auto const& value, ::std::byte* start, ::std::size_t base, ::std::size_t& offset, ::std::size_t reversed, auto& error_code)
+    // serialize 系列写入文档中的位置 p 时写到 start + (p - base)：分段序列化时 start 是窗口，base 是窗口在文档中的起点
 };
 
 #ifndef NA_SERIALIZER_HIDE_IMPL
@@ -391,6 +428,304 @@ template<any_serializer_tag S, any_serialize_option Option, any_serializer_profi
 struct is_node<node<S, Option, Profile, Path>> : ::std::true_type
 {};
 
+//
+// skeleton
+//
+
+/// <summary>
+/// skeleton 是根节点所有 prepend/postpend 常量字节（tag id、名称等）在 minimal 布局下的位置与期望值。
+/// 变长 payload（字符串）之后的字节相对位置会整体平移，所以按变长节点把 skeleton 切成若干 segment，
+/// 每个 segment 内部的偏移都是编译期常量，用少量带掩码的宽比较一次校验完。
+/// </summary>
+struct skeleton_run
+{
+    size_type segment;
+    size_type begin;
+    size_type length;
+    size_type pool_offset;
+};
+
+template<typename Node>
+concept node_with_constant_header = requires {
+    Node::prepend_bytes;
+    Node::postpend_bytes;
+};
+
+struct skeleton_helper
+{
+    /// <summary>
+    /// 同一 segment 中两段常量字节之间的间隔不超过 merge_gap 时合并为一次比较（间隔部分掩码为 0）
+    /// </summary>
+    constexpr static size_type merge_gap = 32;
+
+    template<any_node Node>
+    inline consteval static bool ends_segment()
+    {
+        if constexpr (Node::primitive)
+            return !Node::payload_fixed_size;
+        else
+            return false;
+    }
+
+    template<any_node Node>
+    inline consteval static size_type subtree_breaks();
+
+    template<any_node Node>
+    inline consteval static size_type breaks_before();
+
+    struct header_byte
+    {
+        size_type segment;
+        size_type offset;
+        ::std::byte value;
+    };
+
+    template<any_node Node>
+    inline consteval static void collect(::std::vector<header_byte>& out);
+
+    struct layout
+    {
+        ::std::vector<skeleton_run> runs;
+        ::std::vector<::std::byte> expect;
+        ::std::vector<::std::byte> mask;
+    };
+
+    template<any_node Root>
+    inline consteval static layout build()
+    {
+        ::std::vector<header_byte> bytes{};
+        collect<Root>(bytes);
+        layout result{};
+        for (auto const& b : bytes)
+        {
+            if (!result.runs.empty())
+            {
+                auto& last{result.runs.back()};
+                auto const end{last.begin + last.length};
+                if (last.segment == b.segment && b.offset >= end && b.offset - end <= merge_gap)
+                {
+                    for (auto i{end}; i < b.offset; i++)
+                    {
+                        result.expect.push_back(::std::byte{0});
+                        result.mask.push_back(::std::byte{0});
+                    }
+                    result.expect.push_back(b.value);
+                    result.mask.push_back(::std::byte{0xFF});
+                    last.length = b.offset + 1 - last.begin;
+                    continue;
+                }
+            }
+            result.runs.push_back(skeleton_run{b.segment, b.offset, 1, result.expect.size()});
+            result.expect.push_back(b.value);
+            result.mask.push_back(::std::byte{0xFF});
+        }
+        return result;
+    }
+
+    template<size_type Length>
+    inline static bool masked_equal(::std::byte const* current_pos, ::std::byte const* expect, ::std::byte const* mask) noexcept
+    {
+        size_type i{0};
+#if defined(__AVX2__)
+        if constexpr (Length >= 32)
+        {
+            auto diff{_mm256_setzero_si256()};
+            for (; i + 32 <= Length; i += 32)
+            {
+                auto const a{_mm256_loadu_si256(reinterpret_cast<__m256i const*>(current_pos + i))};
+                auto const e{_mm256_loadu_si256(reinterpret_cast<__m256i const*>(expect + i))};
+                auto const m{_mm256_loadu_si256(reinterpret_cast<__m256i const*>(mask + i))};
+                diff = _mm256_or_si256(diff, _mm256_and_si256(_mm256_xor_si256(a, e), m));
+            }
+            if (!_mm256_testz_si256(diff, diff))
+                return false;
+        }
+#endif
+#if defined(__SSE2__)
+        if constexpr (Length >= 16)
+        {
+            auto diff{_mm_setzero_si128()};
+            for (; i + 16 <= Length; i += 16)
+            {
+                auto const a{_mm_loadu_si128(reinterpret_cast<__m128i const*>(current_pos + i))};
+                auto const e{_mm_loadu_si128(reinterpret_cast<__m128i const*>(expect + i))};
+                auto const m{_mm_loadu_si128(reinterpret_cast<__m128i const*>(mask + i))};
+                diff = _mm_or_si128(diff, _mm_and_si128(_mm_xor_si128(a, e), m));
+            }
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xFFFF)
+                return false;
+        }
+#endif
+        ::std::uint64_t diff{0};
+        auto const word{[&](size_type at) {
+            ::std::uint64_t a, e, m;
+            ::std::memcpy(&a, current_pos + at, 8);
+            ::std::memcpy(&e, expect + at, 8);
+            ::std::memcpy(&m, mask + at, 8);
+            diff |= (a ^ e) & m;
+        }};
+        if constexpr (Length >= 8)
+        {
+            for (; i + 8 <= Length; i += 8)
+                word(i);
+            // 剩余不足 8 字节时与前一个字重叠读取
+            if (i != Length)
+                word(Length - 8);
+        }
+        else
+        {
+            for (; i < Length; i++)
+                diff |= static_cast<::std::uint64_t>((current_pos[i] ^ expect[i]) & mask[i]);
+        }
+        return diff == 0;
+    }
+};
+
+template<any_node Node>
+inline constexpr size_type skeleton_subtree_breaks = skeleton_helper::subtree_breaks<Node>();
+
+template<any_node Node>
+inline constexpr size_type skeleton_breaks_before = skeleton_helper::breaks_before<Node>();
+
+template<any_node Node>
+inline constexpr bool skeleton_ends_segment = skeleton_helper::ends_segment<Node>();
+
+template<any_node Node>
+consteval size_type skeleton_helper::subtree_breaks()
+{
+    if constexpr (Node::primitive)
+        return ends_segment<Node>() ? 1 : 0;
+    else
+        return []<typename Ti, Ti... Is>(::std::integer_sequence<Ti, Is...>) {
+            return (skeleton_subtree_breaks<typename Node::template at<node_index<Is>>> + ... + 0);
+        }(::std::make_index_sequence<Node::size>{});
+}
+
+template<any_node Node>
+consteval size_type skeleton_helper::breaks_before()
+{
+    if constexpr (Node::path::size == 0)
+    {
+        return 0;
+    }
+    else
+    {
+        using Parent = node_parent<Node>;
+        return skeleton_breaks_before<Parent> + []<typename Ti, Ti... Is>(::std::integer_sequence<Ti, Is...>) {
+            return (skeleton_subtree_breaks<typename Parent::template at<node_index<Is>>> + ... + 0);
+        }(::std::make_index_sequence<path_last<typename Node::path>::index>{});
+    }
+}
+
+template<any_node Node>
+consteval void skeleton_helper::collect(::std::vector<header_byte>& out)
+{
+    if constexpr (node_with_constant_header<Node>)
+    {
+        for (size_type i{0}; i < Node::prepend_bytes.size(); i++)
+            out.push_back(header_byte{skeleton_breaks_before<Node>, prepend_minimal_offset<Node> + i, Node::prepend_bytes[i]});
+    }
+    if constexpr (!Node::primitive)
+    {
+        []<typename Ti, Ti... Is>(::std::vector<header_byte>& o, ::std::integer_sequence<Ti, Is...>) consteval {
+            (collect<typename Node::template at<node_index<Is>>>(o), ...);
+        }(out, ::std::make_index_sequence<Node::size>{});
+    }
+    if constexpr (node_with_constant_header<Node>)
+    {
+        for (size_type i{0}; i < Node::postpend_bytes.size(); i++)
+            out.push_back(header_byte{skeleton_breaks_before<Node> + skeleton_subtree_breaks<Node>, postpend_minimal_offset<Node> + i, Node::postpend_bytes[i]});
+    }
+}
+
+template<any_node Root>
+struct skeleton
+{
+    struct data_helper
+    {
+        inline consteval static size_type run_count()
+        {
+            return skeleton_helper::build<Root>().runs.size();
+        }
+
+        inline consteval static size_type pool_size()
+        {
+            return skeleton_helper::build<Root>().expect.size();
+        }
+    };
+
+    constexpr static size_type segment_count = skeleton_subtree_breaks<Root> + 1;
+
+    constexpr static size_type run_count = data_helper::run_count();
+
+    constexpr static size_type pool_size = data_helper::pool_size();
+
+    struct data
+    {
+        ::std::array<skeleton_run, run_count> runs;
+        ::std::array<::std::byte, pool_size> expect;
+        ::std::array<::std::byte, pool_size> mask;
+    };
+
+    inline consteval static data data_impl()
+    {
+        auto const l{skeleton_helper::build<Root>()};
+        data result{};
+        for (size_type i{0}; i < run_count; i++)
+            result.runs[i] = l.runs[i];
+        for (size_type i{0}; i < pool_size; i++)
+        {
+            result.expect[i] = l.expect[i];
+            result.mask[i] = l.mask[i];
+        }
+        return result;
+    }
+
+    constexpr static data value = data_impl();
+
+    template<size_type Segment>
+    inline consteval static size_type segment_first_run()
+    {
+        size_type i{0};
+        while (i < run_count && value.runs[i].segment < Segment)
+            i++;
+        return i;
+    }
+
+    template<size_type First, typename Ti, Ti... Is>
+    inline static bool matches_runs(::std::byte const* current_pos, ::std::integer_sequence<Ti, Is...>) noexcept
+    {
+        return (skeleton_helper::masked_equal<value.runs[First + Is].length>(current_pos + value.runs[First + Is].begin, value.expect.data() + value.runs[First + Is].pool_offset, value.mask.data() + value.runs[First + Is].pool_offset) & ... & true);
+    }
+
+    /// <summary>
+    /// 第 0 到 Segment 段（含）的常量字节在 minimal 布局下的结束位置
+    /// </summary>
+    template<size_type Segment>
+    inline consteval static size_type segments_end()
+    {
+        size_type end{0};
+        for (size_type i{0}; i < run_count; i++)
+        {
+            if (value.runs[i].segment <= Segment && value.runs[i].begin + value.runs[i].length > end)
+                end = value.runs[i].begin + value.runs[i].length;
+        }
+        return end;
+    }
+
+    /// <summary>
+    /// 校验第 Segment 段的所有常量字节，offset 为进入该段时累计的变长偏移
+    /// </summary>
+    template<size_type Segment>
+    inline static bool matches(::std::byte const* start, size_type offset) noexcept
+    {
+        static_assert(Segment < segment_count);
+        constexpr auto first{segment_first_run<Segment>()};
+        constexpr auto last{segment_first_run<Segment + 1>()};
+        return matches_runs<first>(start + offset, ::std::make_index_sequence<last - first>{});
+    }
+};
+
 //
 // serialize sequence
 //
@@ -398,6 +733,48 @@ struct is_node<node<S, Option, Profile, Path>> : ::std::true_type
 struct no_context
 {};
 
+/// <summary>
+/// 一次 deserialize 调用的分配上下文，变长数据都从 resource 分配；
+/// 通常指向调用方持有的 monotonic_buffer_resource，解码结果不再使用后整块释放
+/// </summary>
+struct allocation_context
+{
+    ::std::pmr::memory_resource* resource;
+};
+
+/// <summary>
+/// deserialize_inplace 的上下文：输入缓冲区可写，节点可以在其中就地转换数据；同样可以指定 resource
+/// </summary>
+struct inplace_context
+{
+    ::std::pmr::memory_resource* resource{nullptr};
+    constexpr static bool inplace = true;
+};
+
+template<typename Context>
+concept any_inplace_context = requires { requires ::std::remove_cvref_t<Context>::inplace; };
+
+/// <summary>
+/// 只解码某个子树时代替根对象传给节点：value 是 Path 指向的节点的值，路径更深的节点从它开始查找
+/// </summary>
+template<any_node_path Path, typename T>
+struct subtree_reference
+{
+    using path = Path;
+    T& value;
+};
+
+template<typename T>
+struct is_subtree_reference : ::std::false_type
+{};
+
+template<any_node_path Path, typename T>
+struct is_subtree_reference<subtree_reference<Path, T>> : ::std::true_type
+{};
+
+template<typename T>
+concept any_subtree_reference = is_subtree_reference<::std::remove_cvref_t<T>>::value;
+
 enum class serialize_steps
 {
     prepend,
@@ -427,6 +804,19 @@ template<any_node Node, serialize_steps Step>
 struct is_serialize_step<serialize_step<Node, Step>> : ::std::true_type
 {};
 
+/// <summary>
+/// 序列化时 direct copy step 是否顺带写出该节点的 prepend（prepend 全部是常量字节时），省去单独的 prepend step
+/// </summary>
+template<any_node Node, operations Operation>
+inline constexpr bool directcopy_absorbs_prepend = []() {
+    if constexpr (Operation != operations::serialize || !Node::primitive || !Node::payload_memory_compatible || Node::path::size == 0)
+        return false;
+    else if constexpr (node_with_constant_header<Node>)
+        return Node::prepend_fixed_size && Node::prepend_bytes.size() == Node::prepend_minimal_size;
+    else
+        return false;
+}();
+
 template<any_node... Nodes>
 struct serialize_step_directcopy
 {
@@ -438,22 +828,39 @@ struct serialize_step_directcopy
     template<any_node... Ns>
     using append = serialize_step_directcopy<Nodes..., Ns...>;
 
-    struct length_helper
+    /// <summary>
+    /// 序列化时这段 step 在输出中的起始位置（minimal 布局）：第一个节点的 prepend 被吸收时从 prepend 开始
+    /// </summary>
+    constexpr static size_type begin = directcopy_absorbs_prepend<at<0>, operations::serialize> ? prepend_minimal_offset<at<0>> : payload_minimal_offset<at<0>>;
+
+    /// <summary>
+    /// 序列化时这段 step 写出的字节数。相邻 step 之间没有其他 step，所以写出的范围是连续的：
+    /// 各节点被吸收的常量 prepend 与 payload 首尾相接
+    /// </summary>
+    constexpr static size_type length = ((directcopy_absorbs_prepend<Nodes, operations::serialize> ? Nodes::prepend_minimal_size : 0) + ... + 0) + (payload_minimal_size<Nodes> + ... + 0);
+
+    struct image_helper
     {
-        inline consteval auto length()
+        inline consteval static ::std::array<::std::byte, length> image()
         {
-            if constexpr (size == 1)
-            {
-                return payload_minimal_size<at<0>>;
-            }
-            else
-            {
-                return (payload_minimal_size<Nodes> + ...);
-            }
+            static_assert(payload_minimal_offset<at<size - 1>> + payload_minimal_size<at<size - 1>> - begin == length);
+            ::std::array<::std::byte, length> result{};
+            auto const place{[&result]<typename N>() {
+                if constexpr (directcopy_absorbs_prepend<N, operations::serialize>)
+                {
+                    for (size_type i{0}; i < N::prepend_minimal_size; i++)
+                        result[prepend_minimal_offset<N> - begin + i] = N::prepend_bytes[i];
+                }
+            }};
+            (place.template operator()<Nodes>(), ...);
+            return result;
         }
     };
 
-    constexpr static size_type length = length_helper::length();
+    /// <summary>
+    /// 序列化时这段输出的模板：常量 prepend 已经就位，payload 处为 0
+    /// </summary>
+    constexpr static ::std::array<::std::byte, length> image = image_helper::image();
 };
 
 template<any_node... Nodes>
@@ -473,15 +880,20 @@ struct serialize_step_list
 
 struct generate_serialize_step_list_helper
 {
-    template<any_node Node, typename T, T... Is>
+    template<any_node Node, operations Operation, typename T, T... Is>
     inline consteval static auto generate_serialize_step_list_generate_composite_payload(::std::integer_sequence<T, Is...>);
 
-    template<any_node Node>
+    template<any_node Node, operations Operation>
     inline consteval static auto generate_serialize_step_list_generate()
     {
         auto prepend{
             []() {
-                if constexpr (Node::prepend_minimal_size == 0 && Node::prepend_fixed_size)
+                // 根节点总是保留 prepend step，作为整体校验的入口
+                if constexpr (Node::prepend_minimal_size == 0 && Node::prepend_fixed_size && Node::path::size != 0)
+                    return ::std::tuple<>{};
+                else if constexpr (Operation == operations::deserialize && Node::path::size != 0 && requires { requires Node::deserialize_prepend_noop; })
+                    return ::std::tuple<>{};
+                else if constexpr (directcopy_absorbs_prepend<Node, Operation>)
                     return ::std::tuple<>{};
                 else
                     return ::std::tuple<serialize_step<Node, serialize_steps::prepend>>{};
@@ -490,6 +902,8 @@ struct generate_serialize_step_list_helper
             []() {
                 if constexpr (Node::postpend_minimal_size == 0 && Node::postpend_fixed_size)
                     return ::std::tuple<>{};
+                else if constexpr (Operation == operations::deserialize && requires { requires Node::deserialize_postpend_noop; })
+                    return ::std::tuple<>{};
                 else
                     return ::std::tuple<serialize_step<Node, serialize_steps::postpend>>{};
             }()};
@@ -508,7 +922,7 @@ struct generate_serialize_step_list_helper
         }
         else
         {
-            return ::std::tuple_cat(prepend, generate_serialize_step_list_generate_composite_payload<Node>(::std::make_index_sequence<Node::size>{}), postpend);
+            return ::std::tuple_cat(prepend, generate_serialize_step_list_generate_composite_payload<Node, Operation>(::std::make_index_sequence<Node::size>{}), postpend);
         }
     }
 
@@ -543,8 +957,8 @@ struct generate_serialize_step_list_helper
         {
             auto compact_func = []<typename Tpl, size_type Index = 1>(auto self)
             {
-                static_assert(Index <= ::std::tuple_size_v<Tuple>);
-                if constexpr (Index == ::std::tuple_size_v<Tuple>)
+                static_assert(Index <= ::std::tuple_size_v<Tpl>);
+                if constexpr (Index == ::std::tuple_size_v<Tpl>)
                     return Tpl{};
                 else
                 {
@@ -552,11 +966,12 @@ struct generate_serialize_step_list_helper
                     using Last = ::std::tuple_element_t<Index - 1, Tpl>;
                     if constexpr (Last::step == serialize_steps::payload_directcopy && This::step == serialize_steps::payload_directcopy)
                     {
+                        // 把 This 并入 Last 后删去 This，同一位置继续与下一个 step 合并
                         static_assert(This::size == 1);
                         using NewLast = Last::template append<typename This::template at<0>>;
-                        constexpr auto replaced{tuple_replace_at<Tpl, NewLast, Index - 1>()};
-                        constexpr auto removed{tuple_remove_at<Tpl, Index>()};
-                        return self.template operator()<Tpl, Index>(self);
+                        using Replaced = decltype(tuple_replace_at<Tpl, NewLast, Index - 1>());
+                        using Removed = decltype(tuple_remove_at<Replaced, Index>());
+                        return self.template operator()<Removed, Index>(self);
                     }
                     else
                     {
@@ -615,7 +1030,9 @@ struct generate_serialize_step_list_helper
                                 else
                                 {
                                     using Next = ::std::tuple_element_t<Index + 1, Tpl>;
-                                    if constexpr (::std::same_as<typename Next::node, typename This::node> && Next::step == serialize_steps::postpend)
+                                    if constexpr (Next::step != serialize_steps::postpend)
+                                        return Tpl{};
+                                    else if constexpr (::std::same_as<typename Next::node, typename This::node>)
                                         return tuple_remove_at<Tpl, Index + 1>();
                                     else
                                         return Tpl{};
@@ -635,7 +1052,9 @@ struct generate_serialize_step_list_helper
                                 else
                                 {
                                     using Last = ::std::tuple_element_t<Index - 1, ReplacedTuple>;
-                                    if constexpr (::std::same_as<typename Last::node, typename This::node> && Last::step == serialize_steps::prepend)
+                                    if constexpr (Last::step != serialize_steps::prepend)
+                                        return false;
+                                    else if constexpr (::std::same_as<typename Last::node, typename This::node>)
                                         return true;
                                     else
                                         return false;
@@ -653,10 +1072,10 @@ struct generate_serialize_step_list_helper
         }
     }
 
-    template<any_node Node>
+    template<any_node Node, operations Operation>
     inline static auto generate_serialize_step_list()
     {
-        using Generate = decltype(generate_serialize_step_list_generate<Node>());
+        using Generate = decltype(generate_serialize_step_list_generate<Node, Operation>());
 
         using Compact = decltype(generate_serialize_step_list_compact<Generate>());
 
@@ -668,16 +1087,35 @@ struct generate_serialize_step_list_helper
     }
 };
 
-template<any_node Node, typename T, T... Is>
+template<any_node Node, operations Operation, typename T, T... Is>
 consteval auto generate_serialize_step_list_helper::generate_serialize_step_list_generate_composite_payload(::std::integer_sequence<T, Is...>)
 {
     static_assert(Node::composite);
-    return ::std::tuple_cat(generate_serialize_step_list_generate<typename Node::template at<node_index<Is>>>()...);
+    return ::std::tuple_cat(generate_serialize_step_list_generate<typename Node::template at<node_index<Is>>, Operation>()...);
 }
 
+/// <summary>
+/// 序列化与反序列化的计划不同：反序列化可以省去无事可做的头部 step，使相邻的 direct copy 合并成一个 step
+/// </summary>
+template<any_node Node, operations Operation = operations::serialize>
+using generate_serialize_step_list = decltype(generate_serialize_step_list_helper::generate_serialize_step_list<Node, Operation>());
+
+template<any_node Node, operations Operation>
+struct node_context
+{
+    using type = Node::deserialize_context;
+};
+
 template<any_node Node>
-using generate_serialize_step_list = decltype(generate_serialize_step_list_helper::generate_serialize_step_list<Node>());
+struct node_context<Node, operations::serialize>
+{
+    using type = Node::serialize_context;
+};
 
+template<any_node Node, operations Operation>
+using node_context_t = node_context<Node, Operation>::type;
+
+template<operations Operation>
 struct generate_context_tuple_helper
 {
     template<typename This, size_type I>
@@ -685,7 +1123,7 @@ struct generate_context_tuple_helper
     {
         if constexpr (This::step == serialize_steps::prepend)
         {
-            using Context = This::node::deserialize_context;
+            using Context = node_context_t<typename This::node, Operation>;
             if constexpr (!::std::same_as<Context, no_context>)
                 return ::std::tuple<Context>{};
             else
@@ -707,7 +1145,7 @@ struct generate_context_tuple_helper
     {
         if constexpr (This::step == serialize_steps::prepend)
         {
-            using Context = This::node::deserialize_context;
+            using Context = node_context_t<typename This::node, Operation>;
             if constexpr (!::std::same_as<Context, no_context>)
                 return 1;
             else
@@ -721,33 +1159,23 @@ struct generate_context_tuple_helper
     template<typename Steps, typename Ti, Ti... Is>
     inline consteval static size_type step_context_index(::std::integer_sequence<Ti, Is...>)
     {
-        if constexpr (sizeof...(Is) == 1)
-            return step_context_index_impl<typename Steps::template at<0>>();
-        else
-            return (step_context_index_impl<typename Steps::template at<Is>>() + ...);
+        return (step_context_index_impl<typename Steps::template at<Is>>() + ... + 0);
     }
     template<typename Steps, size_type Index>
     inline consteval static size_type step_context_index_wrapper()
     {
-        if constexpr (Index == 0)
-        {
-            return 0;
-        }
-        else
-        {
-            return step_context_index<Steps>(::std::make_index_sequence<Index - 1>{});
-        }
+        return step_context_index<Steps>(::std::make_index_sequence<Index>{});
     }
 };
 
-template<typename Steps>
-using generate_context_tuple = decltype(generate_context_tuple_helper::generate_context_tuple<Steps>(::std::make_index_sequence<Steps::size>{}));
+template<typename Steps, operations Operation = operations::deserialize>
+using generate_context_tuple = decltype(generate_context_tuple_helper<Operation>::template generate_context_tuple<Steps>(::std::make_index_sequence<Steps::size>{}));
 
-template<typename Steps, size_type Index>
-requires(Index < Steps::size) inline constexpr static size_type step_context_index = generate_context_tuple_helper::step_context_index_wrapper<Steps, Index>();
+template<typename Steps, size_type Index, operations Operation = operations::deserialize>
+requires(Index < Steps::size) inline constexpr static size_type step_context_index = generate_context_tuple_helper<Operation>::template step_context_index_wrapper<Steps, Index>();
 
 template<typename Steps, size_type Index>
-inline constexpr bool deserialize_one(auto& value, ::std::byte const* start, ::std::size_t reversed, auto& error_code, size_type& offset, auto& contexts)
+inline constexpr bool deserialize_one(auto& value, ::std::byte const* start, ::std::size_t reversed, auto& error_code, size_type& offset, auto& contexts, auto& allocation)
 {
     using This = Steps::template at<Index>;
     static_assert(This::step != serialize_steps::payload);
@@ -777,24 +1205,34 @@ inline constexpr bool deserialize_one(auto& value, ::std::byte const* start, ::s
     }
     else if constexpr (This::step == serialize_steps::all)
     {
-        return This::node::deserialize_all(value, start, offset, reversed, error_code);
+        if constexpr (requires { This::node::deserialize_all(value, start, offset, reversed, allocation, error_code); })
+            return This::node::deserialize_all(value, start, offset, reversed, allocation, error_code);
+        else
+            return This::node::deserialize_all(value, start, offset, reversed, error_code);
     }
     else
     {
         static_assert(This::step == serialize_steps::payload_directcopy);
-        ::std::memcpy(start + payload_minimal_offset<typename This::node> + offset, ::std::addressof(This::node::payload_reference(value)), This::length);
+        // 各节点在输入中的位置都是编译期常量加同一个 offset，展开后的复制由编译器合并
+        auto const current_pos{start + offset};
+        [&]<size_type... Ns>(::std::index_sequence<Ns...>) {
+            (::std::memcpy(::std::addressof(This::template at<Ns>::payload_reference(value)), current_pos + payload_minimal_offset<typename This::template at<Ns>>, payload_minimal_size<typename This::template at<Ns>>), ...);
+        }(::std::make_index_sequence<This::size>{});
         return true;
     }
 }
 template<typename Steps, typename Ti, Ti... Is>
-inline constexpr bool deserialize_impl(auto& value, ::std::byte const* start, ::std::size_t reversed, auto& error_code, ::std::integer_sequence<Ti, Is...>)
+inline constexpr bool deserialize_impl(auto& value, ::std::byte const* start, ::std::size_t reversed, auto& error_code, ::std::size_t& offset, auto& allocation, ::std::integer_sequence<Ti, Is...>)
 {
     generate_context_tuple<Steps> contexts{};
-    ::std::size_t offset{0};
-    return (deserialize_one<Steps, Is>(value, start, reversed, error_code, offset, contexts) && ...);
+    return (deserialize_one<Steps, Is>(value, start, reversed, error_code, offset, contexts, allocation) && ...);
 }
+/// <summary>
+/// 反序列化并通过 length 返回实际消耗的字节数，用于从更大的缓冲区中连续读取多个值；
+/// allocation 为 allocation_context 时，变长数据从其中的 resource 分配
+/// </summary>
 template<typename S, typename Option, ::std::size_t E>
-inline constexpr bool deserialize(auto& value, ::std::span<::std::byte const, E> view, auto& error_code) noexcept
+inline constexpr bool deserialize(auto& value, ::std::span<::std::byte const, E> view, ::std::size_t& length, auto& allocation, auto& error_code) noexcept
 {
     using NodeN = node<S, Option, serializer_profile<operations::serialize>, node_path<::std::remove_reference_t<decltype(value)>>>;
     auto const source{view.data()};
@@ -807,27 +1245,885 @@ inline constexpr bool deserialize(auto& value, ::std::span<::std::byte const, E>
     {
         source_length = E;
     }
+    auto const fallback{[&]() {
+        if constexpr (requires { NodeN::deserialize_fallback(value, source, source_length, length, allocation, error_code); })
+            return NodeN::deserialize_fallback(value, source, source_length, length, allocation, error_code);
+        else
+            return false;
+    }};
     using SS = ::std::make_signed_t<::std::size_t>;
     SS reversed{static_cast<SS>(source_length) - static_cast<SS>(total_minimal_size<NodeN>)};
     if (reversed < 0) [[unlikely]]
     {
-        return false;
+        return fallback();
     }
-    using List = generate_serialize_step_list<NodeN>;
-    auto result{deserialize_impl<List>(value, source, reversed, error_code, ::std::make_index_sequence<List::size>{})};
+    using List = generate_serialize_step_list<NodeN, operations::deserialize>;
+    ::std::size_t offset{0};
+    auto result{deserialize_impl<List>(value, source, reversed, error_code, offset, allocation, ::std::make_index_sequence<List::size>{})};
     if (!result) [[unlikely]]
     {
-        return false;
+        return fallback();
     }
     else
     {
+        length = total_minimal_size<NodeN> + offset;
         return true;
     }
 }
+template<typename S, typename Option, ::std::size_t E>
+inline constexpr bool deserialize(auto& value, ::std::span<::std::byte const, E> view, ::std::size_t& length, auto& error_code) noexcept
+{
+    no_context allocation{};
+    return deserialize<S, Option>(value, view, length, allocation, error_code);
+}
+template<typename S, typename Option, ::std::size_t E>
+inline constexpr bool deserialize(auto& value, ::std::span<::std::byte const, E> view, auto& error_code) noexcept
+{
+    ::std::size_t length{0};
+    return deserialize<S, Option>(value, view, length, error_code);
+}
+/// <summary>
+/// 在调用方拥有的可写缓冲区上反序列化：引用缓冲区的成员不复制数据，而是在缓冲区中就地转换。
+/// 转换在整体解码成功后由 Node::deserialize_inplace_finalize 一次完成；失败时缓冲区保持原样
+/// </summary>
+template<typename S, typename Option, ::std::size_t E>
+inline constexpr bool deserialize_inplace(auto& value, ::std::span<::std::byte, E> view, ::std::size_t& length, inplace_context context, auto& error_code) noexcept
+{
+    using NodeN = node<S, Option, serializer_profile<operations::serialize>, node_path<::std::remove_reference_t<decltype(value)>>>;
+    if (!deserialize<S, Option>(value, ::std::span<::std::byte const, E>{view}, length, context, error_code))
+    {
+        return false;
+    }
+    if constexpr (requires { NodeN::deserialize_inplace_finalize(value); })
+    {
+        NodeN::deserialize_inplace_finalize(value);
+    }
+    return true;
+}
+template<typename S, typename Option, ::std::size_t E>
+inline constexpr bool deserialize_inplace(auto& value, ::std::span<::std::byte, E> view, ::std::size_t& length, auto& error_code) noexcept
+{
+    return deserialize_inplace<S, Option>(value, view, length, inplace_context{}, error_code);
+}
+template<typename S, typename Option, ::std::size_t E>
+inline constexpr bool deserialize_inplace(auto& value, ::std::span<::std::byte, E> view, auto& error_code) noexcept
+{
+    ::std::size_t length{0};
+    return deserialize_inplace<S, Option>(value, view, length, inplace_context{}, error_code);
+}
 
-template<typename... Types>
-struct memory_builder
+/// <summary>
+/// 按需读取缓冲区中的单个节点而不反序列化整个 T。目标节点之前的定长部分直接按编译期偏移定位，
+/// 只有之前存在变长节点时才逐个跳过它们来累计 offset；经过的各段常量字节照常校验。
+/// 缓冲区必须在 lazy 及其读出的 view/string 使用期间保持有效
+/// </summary>
+template<typename S, typename Option, typename T>
+struct lazy
 {
+    using root_node = node<S, Option, serializer_profile<operations::serialize>, node_path<T>>;
+
+    template<any_node_path Path>
+    using node_at = node<S, Option, serializer_profile<operations::serialize>, Path>;
+
+    template<::std::size_t E>
+    inline constexpr explicit lazy(::std::span<::std::byte const, E> view) noexcept : source_{view.data()}, source_length_{view.size()}
+    {}
+
+    /// <summary>
+    /// 读取 Path 指向的节点，out 的类型必须与节点类型一致
+    /// </summary>
+    template<any_node_path Path>
+    inline bool get(auto& out, auto& error_code) const noexcept
+    {
+        static_assert(::std::same_as<typename Path::root, T>);
+        using Target = node_at<Path>;
+        static_assert(::std::same_as<::std::remove_cvref_t<decltype(out)>, typename Target::type>);
+        using SS = ::std::make_signed_t<::std::size_t>;
+        SS const reversed_signed{static_cast<SS>(source_length_) - static_cast<SS>(total_minimal_size<root_node>)};
+        if (reversed_signed < 0) [[unlikely]]
+        {
+            error_code = ::std::remove_cvref_t<decltype(error_code)>::end_of_file;
+            return false;
+        }
+        auto const reversed{static_cast<::std::size_t>(reversed_signed)};
+        ::std::size_t offset{0};
+        subtree_reference<Path, ::std::remove_cvref_t<decltype(out)>> reference{out};
+        using Steps = generate_serialize_step_list<Target, operations::deserialize>;
+        if constexpr (Path::size != 0)
+        {
+            // 目标不是根时根节点的 prepend 不在 Steps 中，单独执行以校验第一段
+            typename root_node::deserialize_context context{};
+            if (!root_node::deserialize_prepend(reference, source_, offset, reversed, context, error_code)) [[unlikely]]
+            {
+                return false;
+            }
+            if (!advance<root_node, Path>(offset, reversed, error_code)) [[unlikely]]
+            {
+                return false;
+            }
+        }
+        no_context allocation{};
+        return deserialize_impl<Steps>(reference, source_, reversed, error_code, offset, allocation, ::std::make_index_sequence<Steps::size>{});
+    }
+
+    template<any_node_index... Is>
+    inline bool get(auto& out, auto& error_code) const noexcept
+    {
+        return get<node_path<T, Is...>>(out, error_code);
+    }
+
+    /// <summary>
+    /// 按成员指针读取根的直接成员，例如 get<&T::name>(out, error_code)
+    /// </summary>
+    template<auto Member>
+    requires ::std::is_member_object_pointer_v<decltype(Member)>
+    inline bool get(auto& out, auto& error_code) const noexcept
+    {
+        return get<node_path<T, node_index<root_node::template member_index<Member>>>>(out, error_code);
+    }
+
+private:
+    /// <summary>
+    /// Node 是 Path 的前缀：跳过 Path 在 Node 中之前的所有兄弟子树，再进入下一层
+    /// </summary>
+    template<any_node Node, any_node_path Path>
+    inline bool advance(::std::size_t& offset, ::std::size_t reversed, auto& error_code) const noexcept
+    {
+        if constexpr (Node::path::size == Path::size)
+        {
+            return true;
+        }
+        else
+        {
+            using Next = Path::template at<Node::path::size>;
+            return [&]<size_type... Is>(::std::index_sequence<Is...>) {
+                return (skip<typename Node::template at<node_index<Is>>>(offset, reversed, error_code) && ... && true);
+            }(::std::make_index_sequence<Next::index>{}) && advance<typename Node::template at<Next>, Path>(offset, reversed, error_code);
+        }
+    }
+
+    template<any_node Node>
+    inline bool skip(::std::size_t& offset, ::std::size_t reversed, auto& error_code) const noexcept
+    {
+        if constexpr (skeleton_subtree_breaks<Node> == 0)
+        {
+            // 定长子树不影响后续偏移
+            return true;
+        }
+        else if constexpr (Node::primitive)
+        {
+            return Node::deserialize_skip(source_, offset, reversed, error_code);
+        }
+        else
+        {
+            return [&]<size_type... Is>(::std::index_sequence<Is...>) {
+                return (skip<typename Node::template at<node_index<Is>>>(offset, reversed, error_code) && ...);
+            }(::std::make_index_sequence<Node::size>{});
+        }
+    }
+
+    ::std::byte const* source_;
+    ::std::size_t source_length_;
+};
+
+/// <summary>
+/// stream_decoder 每次追加输入后的状态
+/// </summary>
+enum class stream_status
+{
+    need_more,
+    done,
+    error
+};
+
+/// <summary>
+/// 分块输入的反序列化器：输入依次追加到调用方提供的 storage 中，每次追加后从上次停下的 step 继续，已完成的 step 不会重新执行。
+/// 收到的字节不足 total_minimal_size 时只执行读取范围已经全部到达的 step；之后 step 以 end_of_file 失败表示需要更多输入，
+/// 恢复 offset 后在下次追加时重试。解码出的字符串与 view 引用 storage，storage 需要容纳整个文档并在结果使用期间保持有效。
+/// error_code 的类型需要提供 end_of_file 与 invalid
+/// </summary>
+template<typename S, typename Option, typename T, typename Allocation = no_context>
+struct stream_decoder
+{
+    using root_node = node<S, Option, serializer_profile<operations::serialize>, node_path<T>>;
+    using steps = generate_serialize_step_list<root_node, operations::deserialize>;
+
+    inline stream_decoder(T& value, ::std::span<::std::byte> storage, Allocation allocation = {}) noexcept : value_{::std::addressof(value)}, storage_{storage}, allocation_{allocation}
+    {}
+
+    /// <summary>
+    /// storage 中尚未写入的部分，可以直接在其中接收数据（例如 recv 或解压输出）后调用 commit
+    /// </summary>
+    inline ::std::span<::std::byte> unfilled() const noexcept
+    {
+        return storage_.subspan(available_);
+    }
+
+    /// <summary>
+    /// 确认 unfilled() 开头的 count 个字节已经写入，然后继续解码
+    /// </summary>
+    inline stream_status commit(size_type count, auto& error_code) noexcept
+    {
+        if (status_ != stream_status::need_more)
+        {
+            return status_;
+        }
+        if (!check_room(count, error_code)) [[unlikely]]
+        {
+            return status_ = stream_status::error;
+        }
+        available_ += count;
+        return resume<0>(error_code);
+    }
+
+    /// <summary>
+    /// 把 piece 复制到 storage 末尾，然后继续解码
+    /// </summary>
+    inline stream_status feed(::std::span<::std::byte const> piece, auto& error_code) noexcept
+    {
+        if (status_ != stream_status::need_more)
+        {
+            return status_;
+        }
+        if (!check_room(piece.size(), error_code)) [[unlikely]]
+        {
+            return status_ = stream_status::error;
+        }
+        if (!piece.empty())
+        {
+            ::std::memcpy(storage_.data() + available_, piece.data(), piece.size());
+        }
+        return commit(piece.size(), error_code);
+    }
+
+    /// <summary>
+    /// 输入已经结束：文档不完整时转为 error
+    /// </summary>
+    inline stream_status finish(auto& error_code) noexcept
+    {
+        if (status_ == stream_status::need_more)
+        {
+            error_code = ::std::remove_cvref_t<decltype(error_code)>::end_of_file;
+            status_ = stream_status::error;
+        }
+        return status_;
+    }
+
+    inline stream_status status() const noexcept
+    {
+        return status_;
+    }
+
+    /// <summary>
+    /// 完成后文档的实际长度；storage 中其后的字节属于后续输入
+    /// </summary>
+    inline size_type length() const noexcept
+    {
+        return total_minimal_size<root_node> + offset_;
+    }
+
+    /// <summary>
+    /// 已追加到 storage 的字节数
+    /// </summary>
+    inline size_type available() const noexcept
+    {
+        return available_;
+    }
+
+private:
+    /// <summary>
+    /// storage 放不下最小长度的文档时是 invalid，放不下新到达的 count 字节时是 end_of_file
+    /// </summary>
+    inline bool check_room(size_type count, auto& error_code) const noexcept
+    {
+        using E = ::std::remove_cvref_t<decltype(error_code)>;
+        if (storage_.size() < total_minimal_size<root_node>) [[unlikely]]
+        {
+            error_code = E::invalid;
+            return false;
+        }
+        if (count > storage_.size() - available_) [[unlikely]]
+        {
+            error_code = E::end_of_file;
+            return false;
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// 不足 total_minimal_size 时，执行 step 需要已到达的字节数（offset 为 0）：
+    /// 节点自身在 minimal 布局下的范围，加上 step 可能校验的各段常量字节
+    /// </summary>
+    template<typename Step>
+    inline consteval static size_type requirement()
+    {
+        if constexpr (Step::step == serialize_steps::payload_directcopy)
+        {
+            using Last = Step::template at<Step::size - 1>;
+            return payload_minimal_offset<Last> + payload_minimal_size<Last>;
+        }
+        else
+        {
+            using N = Step::node;
+            constexpr bool header_only{Step::step == serialize_steps::prepend};
+            constexpr size_type extent{header_only ? payload_minimal_offset<N> : prepend_minimal_offset<N> + total_minimal_size<N>};
+            constexpr size_type segments{skeleton<root_node>::template segments_end<skeleton_breaks_before<N> + (header_only ? 0 : skeleton_subtree_breaks<N>)>()};
+            return extent > segments ? extent : segments;
+        }
+    }
+
+    template<size_type I>
+    inline stream_status resume(auto& error_code) noexcept
+    {
+        if constexpr (I == steps::size)
+        {
+            if (available_ < length())
+            {
+                return status_ = stream_status::need_more;
+            }
+            return status_ = stream_status::done;
+        }
+        else
+        {
+            if (step_ == I)
+            {
+                using E = ::std::remove_cvref_t<decltype(error_code)>;
+                ::std::size_t reversed{0};
+                if (available_ >= total_minimal_size<root_node>)
+                {
+                    reversed = available_ - total_minimal_size<root_node>;
+                }
+                else if (requirement<typename steps::template at<I>>() + offset_ > available_)
+                {
+                    return status_ = stream_status::need_more;
+                }
+                auto offset{offset_};
+                error_code = E{};
+                if (!deserialize_one<steps, I>(*value_, storage_.data(), reversed, error_code, offset, contexts_, allocation_)) [[unlikely]]
+                {
+                    if (error_code == E::end_of_file)
+                    {
+                        return status_ = stream_status::need_more;
+                    }
+                    if (error_code == E{})
+                    {
+                        error_code = E::invalid;
+                    }
+                    return status_ = stream_status::error;
+                }
+                offset_ = offset;
+                step_ = I + 1;
+            }
+            return resume<I + 1>(error_code);
+        }
+    }
+
+    T* value_;
+    ::std::span<::std::byte> storage_;
+    Allocation allocation_;
+    generate_context_tuple<steps> contexts_{};
+    size_type available_{0};
+    size_type offset_{0};
+    size_type step_{0};
+    stream_status status_{stream_status::need_more};
+};
+
+struct serialized_size_helper
+{
+    template<any_node Node>
+    inline consteval static bool fixed_size()
+    {
+        if constexpr (!Node::prepend_fixed_size || !Node::postpend_fixed_size)
+            return false;
+        else if constexpr (Node::primitive)
+            return Node::payload_fixed_size;
+        else
+            return []<typename Ti, Ti... Is>(::std::integer_sequence<Ti, Is...>) {
+                return (fixed_size<typename Node::template at<node_index<Is>>>() && ... && true);
+            }(::std::make_index_sequence<Node::size>{});
+    }
+
+    template<any_node Node>
+    inline constexpr static size_type extra_size(auto const& value)
+    {
+        if constexpr (fixed_size<Node>())
+        {
+            return 0;
+        }
+        else
+        {
+            size_type result{0};
+            if constexpr (!Node::prepend_fixed_size)
+                result += Node::prepend_extra_size(value);
+            if constexpr (Node::primitive)
+            {
+                if constexpr (!Node::payload_fixed_size)
+                    result += Node::payload_extra_size(value);
+            }
+            else
+            {
+                result += [&value]<typename Ti, Ti... Is>(::std::integer_sequence<Ti, Is...>) {
+                    return (extra_size<typename Node::template at<node_index<Is>>>(value) + ... + 0);
+                }(::std::make_index_sequence<Node::size>{});
+            }
+            if constexpr (!Node::postpend_fixed_size)
+                result += Node::postpend_extra_size(value);
+            return result;
+        }
+    }
+};
+
+/// <summary>
+/// 整个节点树序列化后的大小都固定时为 true，此时 serialized_size 是编译期常量
+/// </summary>
+template<any_node Node>
+inline constexpr bool serialized_fixed_size = serialized_size_helper::fixed_size<Node>();
+
+/// <summary>
+/// 精确计算 value 序列化后的字节数：total_minimal_size 加上所有变长节点的 extra_size，可用于一次性分配输出缓冲区
+/// </summary>
+template<typename S, typename Option>
+inline constexpr size_type serialized_size(auto const& value) noexcept
+{
+    using NodeN = node<S, Option, serializer_profile<operations::serialize>, node_path<::std::remove_cvref_t<decltype(value)>>>;
+    return total_minimal_size<NodeN> + serialized_size_helper::extra_size<NodeN>(value);
+}
+
+template<any_node Node, size_type Begin>
+inline void directcopy_write_one(auto const& value, ::std::byte* image) noexcept
+{
+    ::std::memcpy(image + payload_minimal_offset<Node> - Begin, ::std::addressof(Node::payload_reference(value)), payload_minimal_size<Node>);
+}
+template<typename Steps, size_type Index>
+inline constexpr bool serialize_one(auto const& value, ::std::byte* start, ::std::size_t base, ::std::size_t reversed, auto& error_code, size_type& offset, auto& contexts)
+{
+    using This = Steps::template at<Index>;
+    static_assert(This::step != serialize_steps::payload);
+    if constexpr (This::step == serialize_steps::prepend)
+    {
+        if constexpr (::std::same_as<typename This::node::serialize_context, no_context>)
+        {
+            no_context dummy{};
+            return This::node::serialize_prepend(value, start, base, offset, reversed, dummy, error_code);
+        }
+        else
+        {
+            return This::node::serialize_prepend(value, start, base, offset, reversed, ::std::get<step_context_index<Steps, Index, operations::serialize>>(contexts), error_code);
+        }
+    }
+    else if constexpr (This::step == serialize_steps::postpend)
+    {
+        if constexpr (::std::same_as<typename This::node::serialize_context, no_context>)
+        {
+            no_context dummy{};
+            return This::node::serialize_postpend(value, start, base, offset, reversed, dummy, error_code);
+        }
+        else
+        {
+            return This::node::serialize_postpend(value, start, base, offset, reversed, ::std::get<step_context_index<Steps, Index, operations::serialize>>(contexts), error_code);
+        }
+    }
+    else if constexpr (This::step == serialize_steps::all)
+    {
+        return This::node::serialize_all(value, start, base, offset, reversed, error_code);
+    }
+    else
+    {
+        static_assert(This::step == serialize_steps::payload_directcopy);
+        // 整段输出先在栈上拼好（常量 prepend 来自模板，payload 来自各成员），再一次写出 length 字节；
+        // 各成员在 value 中不连续，逐个复制到栈上的部分由编译器合并为寄存器操作
+        if constexpr (This::size == 1 && This::begin == payload_minimal_offset<typename This::template at<0>>)
+        {
+            ::std::memcpy(start + (offset + This::begin - base), ::std::addressof(This::template at<0>::payload_reference(value)), This::length);
+            return true;
+        }
+        auto image{This::image};
+        [&]<size_type... Ns>(::std::index_sequence<Ns...>) {
+            (directcopy_write_one<typename This::template at<Ns>, This::begin>(value, image.data()), ...);
+        }(::std::make_index_sequence<This::size>{});
+        ::std::memcpy(start + (offset + This::begin - base), image.data(), This::length);
+        return true;
+    }
+}
+template<typename Steps, typename Ti, Ti... Is>
+inline constexpr bool serialize_impl(auto const& value, ::std::byte* start, ::std::size_t reversed, auto& error_code, size_type& offset, ::std::integer_sequence<Ti, Is...>)
+{
+    generate_context_tuple<Steps, operations::serialize> contexts{};
+    return (serialize_one<Steps, Is>(value, start, 0, reversed, error_code, offset, contexts) && ...);
+}
+/// <summary>
+/// 将 value 写入 view，成功时 length 为实际写入的字节数；view 放不下最小长度的文档时是 end_of_file。
+/// 所有 prepend/postpend（tag id、名称长度、名称等）都在编译期生成，运行时只做一次 memcpy。
+/// </summary>
+template<typename S, typename Option, ::std::size_t E>
+inline constexpr bool serialize(auto const& value, ::std::span<::std::byte, E> view, ::std::size_t& length, auto& error_code) noexcept
+{
+    using NodeN = node<S, Option, serializer_profile<operations::serialize>, node_path<::std::remove_cvref_t<decltype(value)>>>;
+    auto const target{view.data()};
+    ::std::size_t target_length{0};
+    if constexpr (E == ::std::dynamic_extent)
+    {
+        target_length = view.size();
+    }
+    else
+    {
+        target_length = E;
+    }
+    using SS = ::std::make_signed_t<::std::size_t>;
+    SS reversed{static_cast<SS>(target_length) - static_cast<SS>(total_minimal_size<NodeN>)};
+    if (reversed < 0) [[unlikely]]
+    {
+        error_code = ::std::remove_cvref_t<decltype(error_code)>::end_of_file;
+        return false;
+    }
+    using List = generate_serialize_step_list<NodeN>;
+    ::std::size_t offset{0};
+    auto result{serialize_impl<List>(value, target, reversed, error_code, offset, ::std::make_index_sequence<List::size>{})};
+    if (!result) [[unlikely]]
+    {
+        return false;
+    }
+    else
+    {
+        length = total_minimal_size<NodeN> + offset;
+        return true;
+    }
+}
+template<typename S, typename Option, ::std::size_t E>
+inline constexpr bool serialize(auto const& value, ::std::span<::std::byte, E> view, auto& error_code) noexcept
+{
+    ::std::size_t length{0};
+    return serialize<S, Option>(value, view, length, error_code);
+}
+
+struct windowed_step_helper
+{
+    /// <summary>
+    /// step 在 minimal 布局下写入范围的结束位置
+    /// </summary>
+    template<typename Step>
+    inline consteval static size_type end_minimal()
+    {
+        if constexpr (Step::step == serialize_steps::payload_directcopy)
+        {
+            using Last = Step::template at<Step::size - 1>;
+            return payload_minimal_offset<Last> + payload_minimal_size<Last>;
+        }
+        else if constexpr (Step::step == serialize_steps::prepend)
+        {
+            return payload_minimal_offset<typename Step::node>;
+        }
+        else if constexpr (Step::step == serialize_steps::postpend)
+        {
+            return postpend_minimal_offset<typename Step::node> + Step::node::postpend_minimal_size;
+        }
+        else
+        {
+            return prepend_minimal_offset<typename Step::node> + total_minimal_size<typename Step::node>;
+        }
+    }
+
+    /// <summary>
+    /// step 写入的超出 minimal 布局的字节数，即执行后 offset 的增量
+    /// </summary>
+    template<typename Step>
+    inline constexpr static size_type extra(auto const& value)
+    {
+        if constexpr (Step::step == serialize_steps::payload_directcopy)
+        {
+            return 0;
+        }
+        else if constexpr (Step::step == serialize_steps::prepend)
+        {
+            if constexpr (Step::node::prepend_fixed_size)
+                return 0;
+            else
+                return Step::node::prepend_extra_size(value);
+        }
+        else if constexpr (Step::step == serialize_steps::postpend)
+        {
+            if constexpr (Step::node::postpend_fixed_size)
+                return 0;
+            else
+                return Step::node::postpend_extra_size(value);
+        }
+        else
+        {
+            return serialized_size_helper::extra_size<typename Step::node>(value);
+        }
+    }
+};
+
+template<typename Steps, size_type Index>
+inline bool serialize_windowed_one(auto const& value, ::std::span<::std::byte> window, ::std::unique_ptr<::std::byte[]>& oversized, size_type& base, size_type& written, ::std::size_t reversed, auto& error_code, size_type& offset, auto& contexts, auto& sink)
+{
+    using This = Steps::template at<Index>;
+    using E = ::std::remove_cvref_t<decltype(error_code)>;
+    auto const end{windowed_step_helper::end_minimal<This>() + offset + windowed_step_helper::extra<This>(value)};
+    if (end - base > window.size())
+    {
+        if (written != base && !sink(::std::span<::std::byte const>{window.data(), written - base})) [[unlikely]]
+        {
+            error_code = E::invalid;
+            return false;
+        }
+        base = written;
+    }
+    // 节点按整个文档中的绝对位置写入，窗口对应 [base, end)
+    if (end - base <= window.size()) [[likely]]
+    {
+        if (!serialize_one<Steps, Index>(value, window.data(), base, reversed, error_code, offset, contexts)) [[unlikely]]
+        {
+            return false;
+        }
+        written = end;
+        return true;
+    }
+    // 单个 step 比窗口还大（例如很长的变长 list）时只为它临时分配
+    oversized.reset(new (::std::nothrow)::std::byte[end - base]);
+    if (!oversized) [[unlikely]]
+    {
+        error_code = E::invalid;
+        return false;
+    }
+    if (!serialize_one<Steps, Index>(value, oversized.get(), base, reversed, error_code, offset, contexts)) [[unlikely]]
+    {
+        return false;
+    }
+    if (!sink(::std::span<::std::byte const>{oversized.get(), end - base})) [[unlikely]]
+    {
+        error_code = E::invalid;
+        return false;
+    }
+    oversized.reset();
+    base = written = end;
+    return true;
+}
+
+/// <summary>
+/// 以固定大小的窗口分段序列化：step 按输出位置顺序执行，放不下下一个 step 时把窗口中已完成的部分交给 sink 后复用窗口，
+/// 输出不需要整体驻留内存。sink 的签名为 bool(::std::span<::std::byte const>)，返回 false 时以 invalid 中止。
+/// 成功时 length 为写出的总字节数
+/// </summary>
+template<typename S, typename Option>
+inline bool serialize_windowed(auto const& value, ::std::span<::std::byte> window, auto&& sink, ::std::size_t& length, auto& error_code)
+{
+    using NodeN = node<S, Option, serializer_profile<operations::serialize>, node_path<::std::remove_cvref_t<decltype(value)>>>;
+    using List = generate_serialize_step_list<NodeN>;
+    // 每个 step 的写入范围都预先确认在窗口内，变长节点的边界检查只需要整个文档的 extra_size
+    auto const reversed{serialized_size_helper::extra_size<NodeN>(value)};
+    generate_context_tuple<List, operations::serialize> contexts{};
+    ::std::unique_ptr<::std::byte[]> oversized{};
+    size_type base{0};
+    size_type written{0};
+    size_type offset{0};
+    auto const result{[&]<size_type... Is>(::std::index_sequence<Is...>) {
+        return (serialize_windowed_one<List, Is>(value, window, oversized, base, written, reversed, error_code, offset, contexts, sink) && ...);
+    }(::std::make_index_sequence<List::size>{})};
+    if (!result) [[unlikely]]
+    {
+        return false;
+    }
+    if (written != base && !sink(::std::span<::std::byte const>{window.data(), written - base})) [[unlikely]]
+    {
+        error_code = ::std::remove_cvref_t<decltype(error_code)>::invalid;
+        return false;
+    }
+    length = total_minimal_size<NodeN> + offset;
+    return true;
+}
+
+/// <summary>
+/// 分块的只追加输出缓冲区。前 InlineCapacity 字节位于对象内部，之后按块向 Allocator 申请，已写入的数据永远不会被搬移。
+/// reserve 返回一段连续的可写窗口，写完后用 commit 提交实际使用的字节数。
+/// </summary>
+template<size_type InlineCapacity = 256, typename Allocator = ::std::allocator<::std::byte>>
+struct memory_builder
+{
+    struct chunk
+    {
+        chunk* next;
+        ::std::byte* data;
+        size_type capacity;
+        size_type used;
+    };
+
+    struct alignas(alignof(::std::max_align_t)) block
+    {
+        ::std::byte storage[alignof(::std::max_align_t)];
+    };
+
+    using allocator_type = ::std::allocator_traits<Allocator>::template rebind_alloc<block>;
+
+    constexpr static size_type inline_capacity = InlineCapacity;
+
+    constexpr static size_type first_chunk_capacity = InlineCapacity < 128 ? 256 : InlineCapacity * 2;
+
+    constexpr static size_type max_chunk_capacity = static_cast<size_type>(1) << 22;
+
+    inline explicit memory_builder(allocator_type const& allocator = allocator_type{}) noexcept
+      : allocator_{allocator}
+    {}
+
+    memory_builder(memory_builder const&) = delete;
+
+    memory_builder& operator=(memory_builder const&) = delete;
+
+    inline ~memory_builder()
+    {
+        release();
+    }
+
+    inline ::std::span<::std::byte> reserve(size_type length)
+    {
+        if (tail_->capacity - tail_->used >= length) [[likely]]
+        {
+            return {tail_->data + tail_->used, length};
+        }
+        return reserve_slow(length);
+    }
+
+    inline void commit(size_type length) noexcept
+    {
+        tail_->used += length;
+        size_ += length;
+    }
+
+    inline void append(::std::byte const* data, size_type length)
+    {
+        while (length != 0)
+        {
+            auto const available{tail_->capacity - tail_->used};
+            if (available == 0)
+            {
+                reserve_slow(length);
+                continue;
+            }
+            auto const n{available < length ? available : length};
+            ::std::memcpy(tail_->data + tail_->used, data, n);
+            commit(n);
+            data += n;
+            length -= n;
+        }
+    }
+
+    inline void append(::std::span<::std::byte const> data)
+    {
+        append(data.data(), data.size());
+    }
+
+    inline size_type size() const noexcept
+    {
+        return size_;
+    }
+
+    inline bool empty() const noexcept
+    {
+        return size_ == 0;
+    }
+
+    template<typename F>
+    inline void for_each_chunk(F&& f) const
+    {
+        for (auto c{&head_}; c != nullptr; c = c->next)
+        {
+            if (c->used != 0)
+                f(::std::span<::std::byte const>{c->data, c->used});
+        }
+    }
+
+    inline void copy_to(::std::byte* target) const noexcept
+    {
+        for_each_chunk([&target](::std::span<::std::byte const> c) {
+            ::std::memcpy(target, c.data(), c.size());
+            target += c.size();
+        });
+    }
+
+    /// <summary>
+    /// 清空内容但保留已申请的块，供下一次序列化复用
+    /// </summary>
+    inline void clear() noexcept
+    {
+        for (auto c{&head_}; c != nullptr; c = c->next)
+            c->used = 0;
+        tail_ = &head_;
+        size_ = 0;
+    }
+
+    /// <summary>
+    /// 清空内容并归还所有申请的块
+    /// </summary>
+    inline void release() noexcept
+    {
+        auto c{head_.next};
+        while (c != nullptr)
+        {
+            auto const next{c->next};
+            ::std::allocator_traits<allocator_type>::deallocate(allocator_, reinterpret_cast<block*>(c), blocks_of(c->capacity));
+            c = next;
+        }
+        head_.next = nullptr;
+        head_.used = 0;
+        tail_ = &head_;
+        size_ = 0;
+        next_capacity_ = first_chunk_capacity;
+    }
+
+private:
+    inline constexpr static size_type blocks_of(size_type capacity) noexcept
+    {
+        return (sizeof(chunk) + capacity + sizeof(block) - 1) / sizeof(block);
+    }
+
+    inline ::std::span<::std::byte> reserve_slow(size_type length)
+    {
+        // clear 之后优先复用已有的块
+        while (tail_->next != nullptr)
+        {
+            tail_ = tail_->next;
+            if (tail_->capacity >= length)
+                return {tail_->data, length};
+        }
+        auto const capacity{length > next_capacity_ ? length : next_capacity_};
+        auto const blocks{::std::allocator_traits<allocator_type>::allocate(allocator_, blocks_of(capacity))};
+        auto const c{::new (static_cast<void*>(blocks)) chunk{nullptr, reinterpret_cast<::std::byte*>(blocks) + sizeof(chunk), capacity, 0}};
+        tail_->next = c;
+        tail_ = c;
+        if (next_capacity_ < max_chunk_capacity)
+            next_capacity_ *= 2;
+        return {c->data, length};
+    }
+
+    [[no_unique_address]] allocator_type allocator_;
+    size_type size_{0};
+    size_type next_capacity_{first_chunk_capacity};
+    alignas(::std::max_align_t) ::std::byte inline_storage_[InlineCapacity == 0 ? 1 : InlineCapacity];
+    chunk head_{nullptr, inline_storage_, InlineCapacity, 0};
+    chunk* tail_{&head_};
+};
+
+/// <summary>
+/// 序列化到 memory_builder 的末尾。先用 serialized_size 算出精确大小并申请一段连续窗口，
+/// 定长部分直接写入，只有变长部分（字符串）需要边界检查。
+/// </summary>
+template<typename S, typename Option, size_type InlineCapacity, typename Allocator>
+inline bool serialize(auto const& value, memory_builder<InlineCapacity, Allocator>& builder, auto& error_code)
+{
+    using NodeN = node<S, Option, serializer_profile<operations::serialize>, node_path<::std::remove_cvref_t<decltype(value)>>>;
+    size_type size{0};
+    if constexpr (serialized_fixed_size<NodeN>)
+        size = total_minimal_size<NodeN>;
+    else
+        size = serialized_size<S, Option>(value);
+    auto const window{builder.reserve(size)};
+    ::std::size_t length{0};
+    if (!serialize<S, Option>(value, window, length, error_code)) [[unlikely]]
+    {
+        return false;
+    }
+    builder.commit(length);
+    return true;
 }
 
 }  // namespace na::serializer
\ No newline at end of file
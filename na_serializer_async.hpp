@@ -0,0 +1,207 @@
+#pragma once
+#include "na_serializer.hpp"
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace na::serializer {
+/// <summary>
+/// 惰性启动的协程结果：被 co_await 时才开始执行，结束时对称转移回等待者，不经过调度器。
+/// 最外层可以用 start 启动，之后由事件循环恢复 source/sink 挂起的协程，done 之后读取 result
+/// </summary>
+template<typename T>
+struct task
+{
+    struct promise_type
+    {
+        T value{};
+        ::std::coroutine_handle<> continuation{};
+
+        inline task get_return_object() noexcept
+        {
+            return task{::std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        inline ::std::suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        struct final_awaiter
+        {
+            inline bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            inline ::std::coroutine_handle<> await_suspend(::std::coroutine_handle<promise_type> self) const noexcept
+            {
+                auto const next{self.promise().continuation};
+                return next ? next : ::std::noop_coroutine();
+            }
+
+            inline void await_resume() const noexcept
+            {}
+        };
+
+        inline final_awaiter final_suspend() const noexcept
+        {
+            return {};
+        }
+
+        inline void return_value(T result) noexcept
+        {
+            value = ::std::move(result);
+        }
+
+        // 库中不使用异常
+        [[noreturn]] inline void unhandled_exception() const noexcept
+        {
+            ::std::terminate();
+        }
+    };
+
+    inline explicit task(::std::coroutine_handle<promise_type> handle) noexcept : handle_{handle}
+    {}
+
+    task(task const&) = delete;
+    task& operator=(task const&) = delete;
+
+    inline task(task&& other) noexcept : handle_{::std::exchange(other.handle_, {})}
+    {}
+
+    inline task& operator=(task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle_)
+                handle_.destroy();
+            handle_ = ::std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    inline ~task()
+    {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    inline bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    inline ::std::coroutine_handle<> await_suspend(::std::coroutine_handle<> awaiting) noexcept
+    {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+
+    inline T await_resume() noexcept
+    {
+        return ::std::move(handle_.promise().value);
+    }
+
+    /// <summary>
+    /// 在当前线程上运行到第一次挂起或结束
+    /// </summary>
+    inline void start() noexcept
+    {
+        handle_.resume();
+    }
+
+    inline bool done() const noexcept
+    {
+        return handle_.done();
+    }
+
+    inline T& result() noexcept
+    {
+        return handle_.promise().value;
+    }
+
+private:
+    ::std::coroutine_handle<promise_type> handle_;
+};
+
+/// <summary>
+/// 异步字节源：co_await source.read(buffer) 把数据写入 buffer 开头并返回写入的字节数，0 表示输入结束
+/// </summary>
+template<typename Source>
+concept any_async_source = requires(Source& source, ::std::span<::std::byte> buffer) { source.read(buffer); };
+
+/// <summary>
+/// 异步字节汇：co_await sink.write(piece) 返回 false 表示写入失败
+/// </summary>
+template<typename Sink>
+concept any_async_sink = requires(Sink& sink, ::std::span<::std::byte const> piece) { sink.write(piece); };
+
+/// <summary>
+/// 从异步字节源反序列化：数据直接读入 storage 的空闲部分，每次到达后从停下的 step 继续，
+/// 输入不足时挂起在 source.read 上而不是阻塞线程。storage 需要容纳整个文档（字符串与 view 引用它），
+/// 文档之后多读到的字节留在 storage 中 length 之后。value、source、storage 与 error_code 在协程结束前必须保持有效
+/// </summary>
+template<typename S, typename Option, typename T, any_async_source Source, typename Allocation>
+inline task<bool> async_deserialize(T& value, Source& source, ::std::span<::std::byte> storage, ::std::size_t& length, Allocation allocation, auto& error_code)
+{
+    stream_decoder<S, Option, T, Allocation> decoder{value, storage, allocation};
+    while (true)
+    {
+        auto const buffer{decoder.unfilled()};
+        if (buffer.empty()) [[unlikely]]
+        {
+            // storage 已满但文档仍不完整
+            error_code = ::std::remove_cvref_t<decltype(error_code)>::invalid;
+            co_return false;
+        }
+        ::std::size_t const received{co_await source.read(buffer)};
+        auto const status{received == 0 ? decoder.finish(error_code) : decoder.commit(received, error_code)};
+        if (status == stream_status::done)
+        {
+            length = decoder.length();
+            co_return true;
+        }
+        if (status == stream_status::error)
+            co_return false;
+    }
+}
+
+template<typename S, typename Option, typename T, any_async_source Source>
+inline task<bool> async_deserialize(T& value, Source& source, ::std::span<::std::byte> storage, ::std::size_t& length, auto& error_code)
+{
+    co_return co_await async_deserialize<S, Option>(value, source, storage, length, no_context{}, error_code);
+}
+
+template<typename S, typename Option, typename T, any_async_source Source>
+inline task<bool> async_deserialize(T& value, Source& source, ::std::span<::std::byte> storage, auto& error_code)
+{
+    ::std::size_t length{0};
+    co_return co_await async_deserialize<S, Option>(value, source, storage, length, no_context{}, error_code);
+}
+
+/// <summary>
+/// 序列化到 scratch 后按块写入异步字节汇；序列化本身不会挂起，只有写出时挂起。scratch 可以在多次调用之间复用
+/// </summary>
+template<typename S, typename Option, any_async_sink Sink, size_type InlineCapacity, typename Allocator>
+inline task<bool> async_serialize(auto const& value, Sink& sink, memory_builder<InlineCapacity, Allocator>& scratch, auto& error_code)
+{
+    scratch.clear();
+    if (!serialize<S, Option>(value, scratch, error_code)) [[unlikely]]
+        co_return false;
+    ::std::vector<::std::span<::std::byte const>> pieces{};
+    scratch.for_each_chunk([&pieces](::std::span<::std::byte const> piece) { pieces.push_back(piece); });
+    for (auto const piece : pieces)
+    {
+        if (!co_await sink.write(piece)) [[unlikely]]
+        {
+            error_code = ::std::remove_cvref_t<decltype(error_code)>::invalid;
+            co_return false;
+        }
+    }
+    co_return true;
+}
+}  // namespace na::serializer
\ No newline at end of file
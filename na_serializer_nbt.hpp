@@ -1,30 +1,54 @@
+#pragma once
 #include "na_serializer.hpp"
 #include "pfr_used.hpp"
+#include <algorithm>
+#include <array>
 #include <bit>
 #include <concepts>
 #include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <string_view>
 #include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
 
 namespace na::nbt {
 struct nbt
 {};
 
-template<::std::endian nbt_endian = ::std::endian::big>
+/// <summary>
+/// field_order_tolerant: 定长快速路径校验失败时，退回按 tag 逐项解析，compound 中的字段可以按任意顺序出现
+/// list_element_root: 根节点是 list 中的元素，没有 tag id 与名称（用于变长 list 的元素）
+/// </summary>
+template<::std::endian nbt_endian = ::std::endian::big, bool nbt_field_order_tolerant = false, bool nbt_list_element_root = false>
 struct option : na::serializer::serialize_option
 {
     constexpr static auto endian = nbt_endian;
+    constexpr static bool field_order_tolerant = nbt_field_order_tolerant;
+    constexpr static bool list_element_root = nbt_list_element_root;
 };
 
 template<typename T>
 struct is_option : ::std::false_type
 {};
-template<::std::endian E>
-struct is_option<option<E>> : ::std::true_type
+template<::std::endian E, bool F, bool L>
+struct is_option<option<E, F, L>> : ::std::true_type
 {};
 
 template<typename T>
 concept any_option = is_option<T>::value;
 
+template<any_option Option>
+using element_option = option<Option::endian, Option::field_order_tolerant, true>;
+
 enum class nbt_error
 {
     ok,
@@ -54,6 +78,12 @@ enum nbt_tag_type : ::std::uint8_t
 namespace detail {
 template<typename T>
 inline consteval nbt_tag_type nbt_type_id_impl() noexcept;
+
+/// <summary>
+/// 只声明不定义的对象，仅在常量求值中取它的成员地址，不需要构造 T（pmr 容器等没有 constexpr 构造函数）
+/// </summary>
+template<typename T>
+extern T const member_probe;
 }
 template<typename T>
 constexpr nbt_tag_type nbt_type_id = detail::nbt_type_id_impl<T>();
@@ -82,6 +112,40 @@ using nbt_int_array = ::std::array<nbt_int, N>;
 template<::std::size_t N>
 using nbt_long_array = ::std::array<nbt_long, N>;
 
+// 运行时长度的 list 与 array
+template<any_nbt Type, typename Allocator = ::std::allocator<Type>>
+struct nbt_dynamic_list : ::std::vector<Type, Allocator>
+{
+    using ::std::vector<Type, Allocator>::vector;
+    using type = Type;
+};
+template<typename Allocator = ::std::allocator<nbt_byte>>
+using nbt_dynamic_byte_array = ::std::vector<nbt_byte, Allocator>;
+template<typename Allocator = ::std::allocator<nbt_int>>
+using nbt_dynamic_int_array = ::std::vector<nbt_int, Allocator>;
+template<typename Allocator = ::std::allocator<nbt_long>>
+using nbt_dynamic_long_array = ::std::vector<nbt_long, Allocator>;
+
+namespace pmr {
+template<any_nbt Type>
+using nbt_dynamic_list = na::nbt::nbt_dynamic_list<Type, ::std::pmr::polymorphic_allocator<Type>>;
+using nbt_dynamic_byte_array = na::nbt::nbt_dynamic_byte_array<::std::pmr::polymorphic_allocator<nbt_byte>>;
+using nbt_dynamic_int_array = na::nbt::nbt_dynamic_int_array<::std::pmr::polymorphic_allocator<nbt_int>>;
+using nbt_dynamic_long_array = na::nbt::nbt_dynamic_long_array<::std::pmr::polymorphic_allocator<nbt_long>>;
+}  // namespace pmr
+
+// 直接引用输入缓冲区的 list 与 array，访问元素时才转换字节序；与 nbt_string 一样，输入缓冲区必须比 view 存在得更久
+template<typename T, ::std::endian Endian = ::std::endian::big>
+struct nbt_array_view;
+template<typename T, ::std::endian Endian = ::std::endian::big>
+struct nbt_list_view;
+template<::std::endian Endian = ::std::endian::big>
+using nbt_byte_array_view = nbt_array_view<nbt_byte, Endian>;
+template<::std::endian Endian = ::std::endian::big>
+using nbt_int_array_view = nbt_array_view<nbt_int, Endian>;
+template<::std::endian Endian = ::std::endian::big>
+using nbt_long_array_view = nbt_array_view<nbt_long, Endian>;
+
 namespace detail {
 template<typename T>
 inline constexpr bool is_nbt_list_v = false;
@@ -102,6 +166,36 @@ template<typename T>
 inline constexpr bool is_nbt_long_array_v = false;
 template<::std::size_t N>
 inline constexpr bool is_nbt_long_array_v<nbt_long_array<N>> = true;
+
+template<typename T>
+inline constexpr bool is_nbt_dynamic_list_v = false;
+template<any_nbt T, typename A>
+inline constexpr bool is_nbt_dynamic_list_v<nbt_dynamic_list<T, A>> = true;
+
+template<typename T>
+inline constexpr bool is_nbt_dynamic_byte_array_v = false;
+template<typename A>
+inline constexpr bool is_nbt_dynamic_byte_array_v<nbt_dynamic_byte_array<A>> = true;
+
+template<typename T>
+inline constexpr bool is_nbt_dynamic_int_array_v = false;
+template<typename A>
+inline constexpr bool is_nbt_dynamic_int_array_v<nbt_dynamic_int_array<A>> = true;
+
+template<typename T>
+inline constexpr bool is_nbt_dynamic_long_array_v = false;
+template<typename A>
+inline constexpr bool is_nbt_dynamic_long_array_v<nbt_dynamic_long_array<A>> = true;
+
+template<typename T>
+inline constexpr bool is_nbt_array_view_v = false;
+template<typename T, ::std::endian E>
+inline constexpr bool is_nbt_array_view_v<nbt_array_view<T, E>> = ::std::same_as<T, nbt_byte> || ::std::same_as<T, nbt_int> || ::std::same_as<T, nbt_long>;
+
+template<typename T>
+inline constexpr bool is_nbt_list_view_v = false;
+template<typename T, ::std::endian E>
+inline constexpr bool is_nbt_list_view_v<nbt_list_view<T, E>> = ::std::integral<T> || ::std::floating_point<T>;
 }  // namespace detail
 
 template<typename T>
@@ -116,7 +210,47 @@ template<typename T>
 concept any_nbt_array = any_nbt_byte_array<T> || any_nbt_int_array<T> || any_nbt_long_array<T>;
 
 template<typename T>
-concept any_nbt_compound = boost::pfr::is_implicitly_reflectable_v<T, nbt> && !any_nbt_list<T>;
+concept any_nbt_dynamic_list = detail::is_nbt_dynamic_list_v<T>;
+template<typename T>
+concept any_nbt_dynamic_byte_array = detail::is_nbt_dynamic_byte_array_v<T>;
+template<typename T>
+concept any_nbt_dynamic_int_array = detail::is_nbt_dynamic_int_array_v<T>;
+template<typename T>
+concept any_nbt_dynamic_long_array = detail::is_nbt_dynamic_long_array_v<T>;
+template<typename T>
+concept any_nbt_dynamic_array = any_nbt_dynamic_byte_array<T> || any_nbt_dynamic_int_array<T> || any_nbt_dynamic_long_array<T>;
+template<typename T>
+concept any_nbt_dynamic = any_nbt_dynamic_list<T> || any_nbt_dynamic_array<T>;
+
+template<typename T>
+concept any_nbt_list_view = detail::is_nbt_list_view_v<T>;
+template<typename T>
+concept any_nbt_array_view = detail::is_nbt_array_view_v<T>;
+template<typename T>
+concept any_nbt_byte_array_view = any_nbt_array_view<T> && ::std::same_as<typename T::value_type, nbt_byte>;
+template<typename T>
+concept any_nbt_int_array_view = any_nbt_array_view<T> && ::std::same_as<typename T::value_type, nbt_int>;
+template<typename T>
+concept any_nbt_long_array_view = any_nbt_array_view<T> && ::std::same_as<typename T::value_type, nbt_long>;
+template<typename T>
+concept any_nbt_view = any_nbt_list_view<T> || any_nbt_array_view<T>;
+
+// 运行时才知道长度：自有存储的 dynamic 与引用输入的 view
+template<typename T>
+concept any_nbt_runtime_list = any_nbt_dynamic_list<T> || any_nbt_list_view<T>;
+template<typename T>
+concept any_nbt_runtime_array = any_nbt_dynamic_array<T> || any_nbt_array_view<T>;
+template<typename T>
+concept any_nbt_runtime_length = any_nbt_runtime_list<T> || any_nbt_runtime_array<T>;
+
+// 定长与变长两种形式
+template<typename T>
+concept any_nbt_list_type = any_nbt_list<T> || any_nbt_runtime_list<T>;
+template<typename T>
+concept any_nbt_array_type = any_nbt_array<T> || any_nbt_runtime_array<T>;
+
+template<typename T>
+concept any_nbt_compound = boost::pfr::is_implicitly_reflectable_v<T, nbt> && !any_nbt_list<T> && !any_nbt_array<T> && !any_nbt_runtime_length<T>;
 namespace detail {
 template<typename T>
 consteval nbt_tag_type nbt_type_id_impl() noexcept
@@ -145,7 +279,7 @@ consteval nbt_tag_type nbt_type_id_impl() noexcept
     {
         return nbt_tag_type::tag_double;
     }
-    else if constexpr (any_nbt_byte_array<T>)
+    else if constexpr (any_nbt_byte_array<T> || any_nbt_dynamic_byte_array<T> || any_nbt_byte_array_view<T>)
     {
         return nbt_tag_type::tag_byte_array;
     }
@@ -153,7 +287,7 @@ consteval nbt_tag_type nbt_type_id_impl() noexcept
     {
         return nbt_tag_type::tag_string;
     }
-    else if constexpr (any_nbt_list<T>)
+    else if constexpr (any_nbt_list_type<T>)
     {
         return nbt_tag_type::tag_list;
     }
@@ -161,11 +295,11 @@ consteval nbt_tag_type nbt_type_id_impl() noexcept
     {
         return nbt_tag_type::tag_compound;
     }
-    else if constexpr (any_nbt_int_array<T>)
+    else if constexpr (any_nbt_int_array<T> || any_nbt_dynamic_int_array<T> || any_nbt_int_array_view<T>)
     {
         return nbt_tag_type::tag_int_array;
     }
-    else if constexpr (any_nbt_long_array<T>)
+    else if constexpr (any_nbt_long_array<T> || any_nbt_dynamic_long_array<T> || any_nbt_long_array_view<T>)
     {
         return nbt_tag_type::tag_long_array;
     }
@@ -180,14 +314,15 @@ namespace detail {
 template<any_nbt T>
 inline consteval bool is_simple_nbt_impl()
 {
-    if constexpr (::std::is_arithmetic_v<T> || any_nbt_array<T> || ::std::same_as<T, nbt_string>)
+    if constexpr (::std::is_arithmetic_v<T> || any_nbt_array_type<T> || ::std::same_as<T, nbt_string>)
     {
         return true;
     }
-    else if constexpr (any_nbt_list<T>)
+    else if constexpr (any_nbt_list_type<T>)
     {
+        // 元素本身还带有长度等头部的 list（嵌套 list、array 等）需要逐元素展开
         using U = T::value_type;
-        return is_simple_nbt_impl<U>();
+        return ::std::is_arithmetic_v<U> || ::std::same_as<U, nbt_string>;
     }
     else
     {
@@ -211,22 +346,35 @@ concept any_complex_nbt_list = any_nbt_list<T> && !any_simple_nbt_list<T>;
 template<typename T, std::endian nbt_endian>
 requires(nbt_endian == std::endian::big || nbt_endian == ::std::endian::little) inline constexpr T const endian_get(::std::byte const* current_pos) noexcept
 {
+    // 输入中的数值通常不对齐，只能通过 memcpy 读取
     if constexpr (nbt_endian == std::endian::native)
     {
-        return *reinterpret_cast<const T*>(current_pos);
+        T value;
+        ::std::memcpy(::std::addressof(value), current_pos, sizeof(T));
+        return value;
     }
     else
     {
         if constexpr (::std::integral<T>)
-            return ::std::byteswap(*reinterpret_cast<const T*>(current_pos));
+        {
+            T value;
+            ::std::memcpy(::std::addressof(value), current_pos, sizeof(T));
+            return ::std::byteswap(value);
+        }
         else if constexpr (::std::floating_point<T>)
         {
             if constexpr (::std::same_as<T, float>)
             {
-                return ::std::bit_cast<T>(::std::byteswap(*reinterpret_cast<::std::uint32_t const*>(current_pos)));
+                ::std::uint32_t value;
+                ::std::memcpy(::std::addressof(value), current_pos, sizeof(T));
+                return ::std::bit_cast<T>(::std::byteswap(value));
             }
             else if constexpr (::std::same_as<T, double>)
-                return ::std::bit_cast<T>(::std::byteswap(*reinterpret_cast<::std::uint64_t const*>(current_pos)));
+            {
+                ::std::uint64_t value;
+                ::std::memcpy(::std::addressof(value), current_pos, sizeof(T));
+                return ::std::bit_cast<T>(::std::byteswap(value));
+            }
             else
                 static_assert(::std::same_as<T, float> || ::std::same_as<T, double>);
         }
@@ -236,193 +384,1460 @@ requires(nbt_endian == std::endian::big || nbt_endian == ::std::endian::little)
         }
     }
 }
-}  // namespace na::nbt
 
-template<na::serializer::any_serialize_option Option, na::serializer::any_serializer_profile Profile, na::serializer::any_node_path Path>
-struct na::serializer::node<na::nbt::nbt, Option, Profile, Path>
-  : na::serializer::node_base<na::nbt::nbt, Option, Profile, Path>
+template<typename T, std::endian nbt_endian>
+requires(nbt_endian == std::endian::big || nbt_endian == ::std::endian::little) inline constexpr void endian_set(::std::byte* current_pos, T const value) noexcept
 {
-    using this_type = na::serializer::node<na::nbt::nbt, Option, Profile, Path>;
-
-    struct type_helper
+    if constexpr (nbt_endian == std::endian::native)
     {
-        template<typename Type, size_type Index>
-        inline static consteval auto type_impl_at()
+        ::std::memcpy(current_pos, ::std::addressof(value), sizeof(T));
+    }
+    else
+    {
+        if constexpr (::std::integral<T>)
         {
-            static_assert(Index <= Path::size);
-            if constexpr (Index == Path::size)
+            auto const swapped{::std::byteswap(value)};
+            ::std::memcpy(current_pos, ::std::addressof(swapped), sizeof(T));
+        }
+        else if constexpr (::std::floating_point<T>)
+        {
+            if constexpr (::std::same_as<T, float>)
             {
-                return Type{};
+                auto const swapped{::std::byteswap(::std::bit_cast<::std::uint32_t>(value))};
+                ::std::memcpy(current_pos, ::std::addressof(swapped), sizeof(T));
             }
-            else
+            else if constexpr (::std::same_as<T, double>)
             {
-                using Now = Path::template at<Index>;
-                if constexpr (Now::has_guide)
-                {
-                    return type_impl_at<typename Now::type_guide, Index + 1>();
-                }
-                else
-                {
-                    constexpr size_type I0{Now::index};
-                    if constexpr (na::nbt::any_nbt_compound<Type>)
-                    {
-                        static_assert(I0 < boost::pfr::tuple_size_v<Type>, "nbt_index out of range");
-                        using U = boost::pfr::tuple_element_t<I0, Type>;
-                        return type_impl_at<U, Index + 1>();
-                    }
-                    else
-                    {
-                        static_assert(I0 < Type::nbt_list_length, "nbt_index out of range");
-                        return type_impl_at<typename Type::value_type, Index + 1>();
-                    }
-                }
+                auto const swapped{::std::byteswap(::std::bit_cast<::std::uint64_t>(value))};
+                ::std::memcpy(current_pos, ::std::addressof(swapped), sizeof(T));
             }
+            else
+                static_assert(::std::same_as<T, float> || ::std::same_as<T, double>);
         }
-
-        inline static consteval auto type_impl()
+        else
         {
-            return type_impl_at<typename Path::root, 0>();
+            static_assert(::std::integral<T> || ::std::floating_point<T>);
         }
-    };
+    }
+}
 
-    using type = decltype(type_helper::type_impl());
+namespace detail {
+/// <summary>
+/// 每 Size 字节为一个元素、翻转元素内字节顺序的 pshufb 掩码，覆盖 64 字节以供各宽度共用
+/// </summary>
+template<::std::size_t Size>
+inline constexpr auto byteswap_shuffle_mask = []() {
+    ::std::array<::std::uint8_t, 64> result{};
+    for (::std::size_t i{0}; i < result.size(); i++)
+        result[i] = static_cast<::std::uint8_t>((i % 16) / Size * Size + (Size - 1 - i % Size));
+    return result;
+}();
 
-    constexpr static bool serializable = na::nbt::any_nbt<type>;
+/// <summary>
+/// 逐个元素翻转字节序，作为各向量实现的尾部处理与不支持向量指令时的实现
+/// </summary>
+template<::std::size_t Size>
+inline void byteswap_copy_scalar(::std::byte* out, ::std::byte const* in, ::std::size_t bytes) noexcept
+{
+    using U = ::std::conditional_t<Size == 2, ::std::uint16_t, ::std::conditional_t<Size == 4, ::std::uint32_t, ::std::uint64_t>>;
+    for (; bytes >= Size; bytes -= Size, in += Size, out += Size)
+    {
+        U value;
+        ::std::memcpy(::std::addressof(value), in, Size);
+        value = ::std::byteswap(value);
+        ::std::memcpy(out, ::std::addressof(value), Size);
+    }
+}
 
-    constexpr static bool composite = na::nbt::any_complex_nbt<type>;
+/// <summary>
+/// 批量内核可用的指令集等级，按能力递增
+/// </summary>
+enum class simd_level
+{
+    scalar,
+    ssse3,
+    avx2,
+    avx512bw
+};
 
-    constexpr static bool primitive = na::nbt::any_simple_nbt<type>;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// 各指令集的实现通过 target 属性单独编译，通用 x86-64 构建也能在支持的机器上使用 AVX2/AVX-512
+template<::std::size_t Size>
+__attribute__((target("ssse3"))) inline void byteswap_copy_ssse3(::std::byte* out, ::std::byte const* in, ::std::size_t bytes) noexcept
+{
+    auto const mask{_mm_loadu_si128(reinterpret_cast<__m128i const*>(byteswap_shuffle_mask<Size>.data()))};
+    for (; bytes >= 16; bytes -= 16, in += 16, out += 16)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(in)), mask));
+    byteswap_copy_scalar<Size>(out, in, bytes);
+}
 
-    struct size_helper
+template<::std::size_t Size>
+__attribute__((target("avx2"))) inline void byteswap_copy_avx2(::std::byte* out, ::std::byte const* in, ::std::size_t bytes) noexcept
+{
+    auto const mask{_mm256_loadu_si256(reinterpret_cast<__m256i const*>(byteswap_shuffle_mask<Size>.data()))};
+    for (; bytes >= 32; bytes -= 32, in += 32, out += 32)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(in)), mask));
+    if (bytes >= 16)
     {
-        inline static consteval size_type size_impl()
-        {
-            using T = type;
-            if constexpr (na::nbt::any_nbt_compound<T>)
-                return boost::pfr::tuple_size_v<T>;
-            else if constexpr (na::nbt::any_complex_nbt_list<T>)
-                return T::nbt_list_length;
-            else
-                return 0;
-        }
-    };
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(in)), _mm256_castsi256_si128(mask)));
+        bytes -= 16;
+        in += 16;
+        out += 16;
+    }
+    byteswap_copy_scalar<Size>(out, in, bytes);
+}
 
-    constexpr static size_type size = size_helper::size_impl();
+template<::std::size_t Size>
+__attribute__((target("avx512f,avx512bw"))) inline void byteswap_copy_avx512bw(::std::byte* out, ::std::byte const* in, ::std::size_t bytes) noexcept
+{
+    auto const mask{_mm512_loadu_si512(byteswap_shuffle_mask<Size>.data())};
+    for (; bytes >= 64; bytes -= 64, in += 64, out += 64)
+        _mm512_storeu_si512(out, _mm512_shuffle_epi8(_mm512_loadu_si512(in), mask));
+    if (bytes != 0)
+    {
+        // 剩余部分用掩码读写一次完成，不越过缓冲区末尾
+        auto const tail{static_cast<__mmask64>(~0ULL >> (64 - bytes))};
+        _mm512_mask_storeu_epi8(out, tail, _mm512_shuffle_epi8(_mm512_maskz_loadu_epi8(tail, in), mask));
+    }
+}
 
-    struct data_helper
+/// <summary>
+/// 通过 cpuid 检测当前机器支持的最高等级，只在第一次调用时检测
+/// </summary>
+inline simd_level detected_simd_level() noexcept
+{
+    static simd_level const level{[]() noexcept {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512bw"))
+            return simd_level::avx512bw;
+        if (__builtin_cpu_supports("avx2"))
+            return simd_level::avx2;
+        if (__builtin_cpu_supports("ssse3"))
+            return simd_level::ssse3;
+        return simd_level::scalar;
+    }()};
+    return level;
+}
+#else
+inline simd_level detected_simd_level() noexcept
+{
+    return simd_level::scalar;
+}
+#endif
+
+/// <summary>
+/// 以指定等级执行批量字节序翻转，等级必须不高于 detected_simd_level()
+/// </summary>
+template<::std::size_t Size>
+inline void byteswap_copy_with(simd_level level, ::std::byte* out, ::std::byte const* in, ::std::size_t bytes) noexcept
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    switch (level)
     {
-        template<typename T>
-        inline static consteval bool payload_memory_compatible_impl()
-        {
-            if constexpr (na::nbt::any_complex_nbt<T>)
-            {
-                return false;  // not used
-            }
-            if constexpr (Option::endian == ::std::endian::native)
-            {
-                if constexpr (::std::is_arithmetic_v<T> || na::nbt::any_nbt_array<T>)
-                    return true;
-                else if constexpr (na::nbt::any_nbt_list<T> && payload_memory_compatible_impl<typename T::type>())
-                    return true;
-                else
-                    return false;
-            }
-            else
-            {
-                return false;
-            }
-        }
+    case simd_level::avx512bw:
+        return byteswap_copy_avx512bw<Size>(out, in, bytes);
+    case simd_level::avx2:
+        return byteswap_copy_avx2<Size>(out, in, bytes);
+    case simd_level::ssse3:
+        return byteswap_copy_ssse3<Size>(out, in, bytes);
+    default:
+        break;
+    }
+#endif
+    byteswap_copy_scalar<Size>(out, in, bytes);
+}
 
-        inline constexpr static bool prepend_fixed_size()
-        {
-            return true;
-        }
+template<::std::size_t Size>
+using byteswap_copy_kernel = void (*)(::std::byte*, ::std::byte const*, ::std::size_t) noexcept;
 
-        template<typename T>
-        inline constexpr static bool payload_fixed_size()
+/// <summary>
+/// 按运行时检测到的指令集选出的内核，进程内只解析一次
+/// </summary>
+template<::std::size_t Size>
+inline byteswap_copy_kernel<Size> const byteswap_copy_dispatch = []() noexcept -> byteswap_copy_kernel<Size> {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    switch (detected_simd_level())
+    {
+    case simd_level::avx512bw:
+        return &byteswap_copy_avx512bw<Size>;
+    case simd_level::avx2:
+        return &byteswap_copy_avx2<Size>;
+    case simd_level::ssse3:
+        return &byteswap_copy_ssse3<Size>;
+    default:
+        break;
+    }
+#endif
+    return &byteswap_copy_scalar<Size>;
+}();
+
+/// <summary>
+/// 把 count 个 Size 字节的元素从 src 复制到 dst 并翻转每个元素的字节序；两端都可以不对齐；dst 与 src 可以完全相同（就地翻转），但不能部分重叠
+/// </summary>
+template<::std::size_t Size>
+inline void byteswap_copy(void* dst, void const* src, ::std::size_t count) noexcept
+{
+    static_assert(Size == 1 || Size == 2 || Size == 4 || Size == 8);
+    auto const out{static_cast<::std::byte*>(dst)};
+    auto const in{static_cast<::std::byte const*>(src)};
+    if constexpr (Size == 1)
+    {
+        ::std::memcpy(out, in, count);
+    }
+    else if (count * Size < 16)
+    {
+        // 不足一个向量时不经过间接调用
+        byteswap_copy_scalar<Size>(out, in, count * Size);
+    }
+    else if (auto const kernel{byteswap_copy_dispatch<Size>}; kernel != nullptr) [[likely]]
+    {
+        kernel(out, in, count * Size);
+    }
+    else
+    {
+        // 其他编译单元的静态初始化期间，内核指针可能尚未解析
+        byteswap_copy_with<Size>(detected_simd_level(), out, in, count * Size);
+    }
+}
+
+/// <summary>
+/// 从 count 条等长记录中收集同一个 Size 字节字段：第 i 个值位于 in + i * in_stride，写到 out + i * out_stride，Swap 时翻转字节序。
+/// 作为各向量实现的尾部处理与不支持向量指令时的实现
+/// </summary>
+template<::std::size_t Size, bool Swap>
+inline void gather_column_scalar(::std::byte* out, ::std::size_t out_stride, ::std::byte const* in, ::std::size_t in_stride, ::std::size_t count) noexcept
+{
+    using U = ::std::conditional_t<Size == 1, ::std::uint8_t, ::std::conditional_t<Size == 2, ::std::uint16_t, ::std::conditional_t<Size == 4, ::std::uint32_t, ::std::uint64_t>>>;
+    for (; count != 0; count--, in += in_stride, out += out_stride)
+    {
+        U value;
+        ::std::memcpy(::std::addressof(value), in, Size);
+        if constexpr (Swap && Size != 1)
+            value = ::std::byteswap(value);
+        ::std::memcpy(out, ::std::addressof(value), Size);
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// 4/8 字节字段每个向量从 32/Size（AVX2）或 64/Size（AVX-512）条记录中 gather，一条 pshufb 同时翻转所有值；
+// 输出连续时整条写出，否则 AVX-512 用 scatter，AVX2 经过栈上的临时数组逐个写出。
+// 2 字节字段没有 gather 指令：需要翻转时逐个读入栈上的向量，再用一条 pshufb 翻转。1 字节字段不需要翻转，总是逐个复制
+template<::std::size_t Lanes>
+inline void gather_column_load16(::std::byte* buffer, ::std::byte const* in, ::std::size_t in_stride) noexcept
+{
+    for (::std::size_t i{0}; i < Lanes; i++)
+        ::std::memcpy(buffer + i * 2, in + i * in_stride, 2);
+}
+template<::std::size_t Lanes>
+inline void gather_column_store16(::std::byte* out, ::std::size_t out_stride, ::std::byte const* buffer) noexcept
+{
+    for (::std::size_t i{0}; i < Lanes; i++)
+        ::std::memcpy(out + i * out_stride, buffer + i * 2, 2);
+}
+
+template<::std::size_t Size, bool Swap>
+__attribute__((target("avx2"))) inline void gather_column_avx2(::std::byte* out, ::std::size_t out_stride, ::std::byte const* in, ::std::size_t in_stride, ::std::size_t count) noexcept
+{
+    if constexpr (Size == 2 && Swap)
+    {
+        constexpr ::std::size_t lanes{16};
+        auto const mask{_mm256_loadu_si256(reinterpret_cast<__m256i const*>(byteswap_shuffle_mask<2>.data()))};
+        alignas(32)::std::byte buffer[32];
+        for (; count >= lanes; count -= lanes, in += lanes * in_stride, out += lanes * out_stride)
         {
-            if constexpr (na::nbt::any_complex_nbt<T>)
-            {
-                return false;  // not used
-            }
-            if constexpr (::std::same_as<T, na::nbt::nbt_string>)
-            {
-                return false;
-            }
-            else if constexpr (na::nbt::any_nbt_list<T>)
+            gather_column_load16<lanes>(buffer, in, in_stride);
+            auto const value{_mm256_shuffle_epi8(_mm256_load_si256(reinterpret_cast<__m256i const*>(buffer)), mask)};
+            if (out_stride == Size)
             {
-                return payload_fixed_size<typename T::type>();
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), value);
             }
             else
             {
-                return true;
+                _mm256_store_si256(reinterpret_cast<__m256i*>(buffer), value);
+                gather_column_store16<lanes>(out, out_stride, buffer);
             }
         }
-
-        inline constexpr static bool postpend_fixed_size()
-        {
-            return true;
-        }
-
-        inline constexpr static size_type prepend_minimal_size()
+    }
+    else if constexpr (Size == 4 || Size == 8)
+    {
+        constexpr ::std::size_t lanes{32 / Size};
+        // gather 的下标是 32 位有符号数
+        if (in_stride <= 0x7FFFFFFF / lanes)
         {
-            using Type = type;
-            if constexpr (Path::size == 0)
+            auto const mask{_mm256_loadu_si256(reinterpret_cast<__m256i const*>(byteswap_shuffle_mask<Size>.data()))};
+            for (; count >= lanes; count -= lanes, in += lanes * in_stride, out += lanes * out_stride)
             {
-                if constexpr (na::nbt::any_nbt_list<Type>)
-                    return 1 + 2 + 1 + 4;
-                else if constexpr (na::nbt::any_nbt_array<Type>)
-                    return 1 + 2 + 4;
+                __m256i value;
+                if constexpr (Size == 4)
+                    value = _mm256_i32gather_epi32(reinterpret_cast<int const*>(in), _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(static_cast<int>(in_stride))), 1);
                 else
-                    return 1 + 2;
-            }
-            else
-            {
-                using ParentType = node_parent<this_type>::type;
-                constexpr auto Index = path_last<Path>::index;
-                if constexpr (na::nbt::any_nbt_compound<ParentType>)
+                    value = _mm256_i32gather_epi64(reinterpret_cast<long long const*>(in), _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(static_cast<int>(in_stride))), 1);
+                if constexpr (Swap)
+                    value = _mm256_shuffle_epi8(value, mask);
+                if (out_stride == Size)
                 {
-                    if constexpr (na::nbt::any_nbt_list<Type>)
-                        return static_cast<::std::size_t>(1) + 2 + boost::pfr::get_name<Index, ParentType>().size() + 1 + 4;
-                    else if constexpr (na::nbt::any_nbt_array<Type>)
-                        return static_cast<::std::size_t>(1) + 2 + boost::pfr::get_name<Index, ParentType>().size() + 4;
-                    else
-                        return static_cast<::std::size_t>(1) + 2 + boost::pfr::get_name<Index, ParentType>().size();
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), value);
                 }
-                else  // list
+                else
                 {
-                    static_assert(na::nbt::any_complex_nbt_list<ParentType>);
-                    if constexpr (na::nbt::any_nbt_list<Type>)
-                        return 1 + 4;
-                    else if constexpr (na::nbt::any_nbt_array<Type>)
-                        return 4;
-                    else
-                        return 0;
+                    alignas(32)::std::byte buffer[32];
+                    _mm256_store_si256(reinterpret_cast<__m256i*>(buffer), value);
+                    for (::std::size_t i{0}; i < lanes; i++)
+                        ::std::memcpy(out + i * out_stride, buffer + i * Size, Size);
                 }
             }
         }
+    }
+    gather_column_scalar<Size, Swap>(out, out_stride, in, in_stride, count);
+}
 
-        template<typename T>
-        inline constexpr static size_type payload_minimal_size()
+template<::std::size_t Size, bool Swap>
+__attribute__((target("avx512f,avx512bw"))) inline void gather_column_avx512bw(::std::byte* out, ::std::size_t out_stride, ::std::byte const* in, ::std::size_t in_stride, ::std::size_t count) noexcept
+{
+    if constexpr (Size == 2 && Swap)
+    {
+        constexpr ::std::size_t lanes{32};
+        auto const mask{_mm512_loadu_si512(byteswap_shuffle_mask<2>.data())};
+        alignas(64)::std::byte buffer[64];
+        for (; count >= lanes; count -= lanes, in += lanes * in_stride, out += lanes * out_stride)
         {
-            if constexpr (na::nbt::any_complex_nbt<T>)
-            {
-                return 0;  // not used
-            }
-            if constexpr (std::integral<T> || std::floating_point<T>)
+            gather_column_load16<lanes>(buffer, in, in_stride);
+            auto const value{_mm512_shuffle_epi8(_mm512_load_si512(buffer), mask)};
+            if (out_stride == Size)
             {
-                return sizeof(T);
+                _mm512_storeu_si512(out, value);
             }
-            else if constexpr (na::nbt::any_nbt_array<T>)
+            else
             {
-                using U = T::value_type;
-                return ::std::tuple_size_v<T> * sizeof(U);
+                _mm512_store_si512(buffer, value);
+                gather_column_store16<lanes>(out, out_stride, buffer);
             }
-            else if constexpr (std::same_as<T, na::nbt::nbt_string>)
+        }
+    }
+    else if constexpr (Size == 4 || Size == 8)
+    {
+        constexpr ::std::size_t lanes{64 / Size};
+        if (in_stride <= 0x7FFFFFFF / lanes && out_stride <= 0x7FFFFFFF / lanes)
+        {
+            auto const mask{_mm512_loadu_si512(byteswap_shuffle_mask<Size>.data())};
+            auto const lane{_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)};
+            auto const in_index{_mm512_mullo_epi32(lane, _mm512_set1_epi32(static_cast<int>(in_stride)))};
+            auto const out_index{_mm512_mullo_epi32(lane, _mm512_set1_epi32(static_cast<int>(out_stride)))};
+            // 8 字节字段只用 8 个下标，单独算出 256 位的下标，不经过带入未定义高半部分的 _mm512_castsi512_si256
+            auto const lane_low{_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)};
+            auto const in_index_low{_mm256_mullo_epi32(lane_low, _mm256_set1_epi32(static_cast<int>(in_stride)))};
+            auto const out_index_low{_mm256_mullo_epi32(lane_low, _mm256_set1_epi32(static_cast<int>(out_stride)))};
+            for (; count >= lanes; count -= lanes, in += lanes * in_stride, out += lanes * out_stride)
             {
-                return 2 /* name length */;
+                __m512i value;
+                if constexpr (Size == 4)
+                    value = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), __mmask16(0xFFFF), in_index, in, 1);
+                else
+                    value = _mm512_mask_i32gather_epi64(_mm512_setzero_si512(), __mmask8(0xFF), in_index_low, in, 1);
+                if constexpr (Swap)
+                    value = _mm512_shuffle_epi8(value, mask);
+                if (out_stride == Size)
+                    _mm512_storeu_si512(out, value);
+                else if constexpr (Size == 4)
+                    _mm512_i32scatter_epi32(out, out_index, value, 1);
+                else
+                    _mm512_i32scatter_epi64(out, out_index_low, value, 1);
             }
-            else if constexpr (na::nbt::any_nbt_list<T>)
+        }
+    }
+    gather_column_scalar<Size, Swap>(out, out_stride, in, in_stride, count);
+}
+#endif
+
+/// <summary>
+/// 以指定等级收集字段，等级必须不高于 detected_simd_level()；SSSE3 没有 gather，与逐个实现相同
+/// </summary>
+template<::std::size_t Size, bool Swap>
+inline void gather_column_with(simd_level level, ::std::byte* out, ::std::size_t out_stride, ::std::byte const* in, ::std::size_t in_stride, ::std::size_t count) noexcept
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    switch (level)
+    {
+    case simd_level::avx512bw:
+        return gather_column_avx512bw<Size, Swap>(out, out_stride, in, in_stride, count);
+    case simd_level::avx2:
+        return gather_column_avx2<Size, Swap>(out, out_stride, in, in_stride, count);
+    default:
+        break;
+    }
+#endif
+    gather_column_scalar<Size, Swap>(out, out_stride, in, in_stride, count);
+}
+
+using gather_column_kernel = void (*)(::std::byte*, ::std::size_t, ::std::byte const*, ::std::size_t, ::std::size_t) noexcept;
+
+template<::std::size_t Size, bool Swap>
+inline gather_column_kernel const gather_column_dispatch = []() noexcept -> gather_column_kernel {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    if constexpr (Size == 4 || Size == 8 || (Size == 2 && Swap))
+    {
+        switch (detected_simd_level())
+        {
+        case simd_level::avx512bw:
+            return &gather_column_avx512bw<Size, Swap>;
+        case simd_level::avx2:
+            return &gather_column_avx2<Size, Swap>;
+        default:
+            break;
+        }
+    }
+#endif
+    return &gather_column_scalar<Size, Swap>;
+}();
+
+/// <summary>
+/// count 条记录的列是否值得交给向量实现：1 字节与不需要翻转的 2 字节字段没有收益，记录数不足一个 64 字节向量时也不值得
+/// </summary>
+template<::std::size_t Size, bool Swap>
+inline constexpr bool gather_column_vectorized(::std::size_t count) noexcept
+{
+    static_assert(Size == 1 || Size == 2 || Size == 4 || Size == 8);
+    if constexpr (Size == 1 || (Size == 2 && !Swap))
+        return false;
+    else
+        return count >= 64 / Size;
+}
+
+/// <summary>
+/// 收集 count 条记录中的同一字段，按运行时检测到的指令集选择实现
+/// </summary>
+template<::std::size_t Size, bool Swap>
+inline void gather_column(::std::byte* out, ::std::size_t out_stride, ::std::byte const* in, ::std::size_t in_stride, ::std::size_t count) noexcept
+{
+    if (!gather_column_vectorized<Size, Swap>(count))
+    {
+        gather_column_scalar<Size, Swap>(out, out_stride, in, in_stride, count);
+    }
+    else if (auto const kernel{gather_column_dispatch<Size, Swap>}; kernel != nullptr) [[likely]]
+    {
+        kernel(out, out_stride, in, in_stride, count);
+    }
+    else
+    {
+        gather_column_with<Size, Swap>(detected_simd_level(), out, out_stride, in, in_stride, count);
+    }
+}
+}  // namespace detail
+
+/// <summary>
+/// 批量读取 count 个数值，用于 array 与数值 list
+/// </summary>
+template<typename T, std::endian nbt_endian>
+requires(nbt_endian == std::endian::big || nbt_endian == ::std::endian::little) inline void endian_get_n(T* dst, ::std::byte const* src, ::std::size_t count) noexcept
+{
+    static_assert(::std::integral<T> || ::std::floating_point<T>);
+    if constexpr (nbt_endian == std::endian::native || sizeof(T) == 1)
+        ::std::memcpy(dst, src, count * sizeof(T));
+    else
+        detail::byteswap_copy<sizeof(T)>(dst, src, count);
+}
+
+/// <summary>
+/// 批量写出 count 个数值，用于 array 与数值 list
+/// </summary>
+template<typename T, std::endian nbt_endian>
+requires(nbt_endian == std::endian::big || nbt_endian == ::std::endian::little) inline void endian_set_n(::std::byte* dst, T const* src, ::std::size_t count) noexcept
+{
+    static_assert(::std::integral<T> || ::std::floating_point<T>);
+    if constexpr (nbt_endian == std::endian::native || sizeof(T) == 1)
+        ::std::memcpy(dst, src, count * sizeof(T));
+    else
+        detail::byteswap_copy<sizeof(T)>(dst, src, count);
+}
+
+template<typename T, ::std::endian Endian>
+struct nbt_array_view
+{
+    static_assert(::std::integral<T> || ::std::floating_point<T>);
+    using value_type = T;
+    constexpr static ::std::endian endian = Endian;
+
+    struct iterator
+    {
+        ::std::byte const* current_pos;
+
+        inline T operator*() const noexcept
+        {
+            return endian_get<T, Endian>(current_pos);
+        }
+
+        inline iterator& operator++() noexcept
+        {
+            current_pos += sizeof(T);
+            return *this;
+        }
+
+        inline bool operator==(iterator const&) const noexcept = default;
+    };
+
+    constexpr nbt_array_view() noexcept = default;
+
+    constexpr nbt_array_view(::std::byte const* bytes, ::std::size_t length) noexcept
+      : bytes_{bytes}, length_{length}
+    {}
+
+    inline constexpr ::std::size_t size() const noexcept
+    {
+        return length_;
+    }
+
+    inline constexpr bool empty() const noexcept
+    {
+        return length_ == 0;
+    }
+
+    /// <summary>
+    /// 输入中的原始字节，字节序为 Endian
+    /// </summary>
+    inline constexpr ::std::byte const* data() const noexcept
+    {
+        return bytes_;
+    }
+
+    inline T operator[](::std::size_t index) const noexcept
+    {
+        return endian_get<T, Endian>(bytes_ + index * sizeof(T));
+    }
+
+    inline iterator begin() const noexcept
+    {
+        return iterator{bytes_};
+    }
+
+    inline iterator end() const noexcept
+    {
+        return iterator{bytes_ + length_ * sizeof(T)};
+    }
+
+    /// <summary>
+    /// 批量转换全部元素，dst 至少容纳 size() 个元素
+    /// </summary>
+    inline void copy_to(T* dst) const noexcept
+    {
+        endian_get_n<T, Endian>(dst, bytes_, length_);
+    }
+
+    /// <summary>
+    /// 数据为本机字节序且按 T 对齐时直接返回元素 span，否则返回空 span，此时只能逐个访问或 copy_to
+    /// </summary>
+    inline ::std::span<T const> aligned_span() const noexcept
+    requires(Endian == ::std::endian::native)
+    {
+        if (reinterpret_cast<::std::uintptr_t>(bytes_) % alignof(T) != 0)
+            return {};
+        return ::std::span<T const>{reinterpret_cast<T const*>(bytes_), length_};
+    }
+
+private:
+    ::std::byte const* bytes_{};
+    ::std::size_t length_{};
+};
+
+template<typename T, ::std::endian Endian>
+struct nbt_list_view : nbt_array_view<T, Endian>
+{
+    using nbt_array_view<T, Endian>::nbt_array_view;
+    using type = T;
+};
+
+// compression
+
+/// <summary>
+/// 磁盘上 NBT 的压缩格式；数值与 region 文件中 chunk 的压缩类型字节一致
+/// </summary>
+enum class compression : ::std::uint8_t
+{
+    gzip = 1,
+    zlib = 2,
+    none = 3
+};
+
+/// <summary>
+/// 按魔数判断压缩格式：gzip 以 1F 8B 开头，zlib 的前两个字节按大端是 31 的倍数且压缩方法为 deflate
+/// </summary>
+inline compression detect_compression(::std::span<::std::byte const> input) noexcept
+{
+    if (input.size() >= 2)
+    {
+        auto const b0{static_cast<::std::uint8_t>(input[0])};
+        auto const b1{static_cast<::std::uint8_t>(input[1])};
+        if (b0 == 0x1F && b1 == 0x8B)
+            return compression::gzip;
+        if ((b0 & 0x0F) == 8 && (b0 >> 4) <= 7 && ((b0 << 8) | b1) % 31 == 0)
+            return compression::zlib;
+    }
+    return compression::none;
+}
+
+/// <summary>
+/// 解压输出缓冲区，只增不减；可以在解压器之间移交，使解压结果在交给其他线程反序列化后再归还复用
+/// </summary>
+struct decompress_buffer
+{
+    ::std::unique_ptr<::std::byte[]> data{};
+    ::std::size_t capacity{0};
+
+    inline decompress_buffer() noexcept = default;
+
+    // 移动后源对象的容量归零，之后 reserve 会重新分配而不是返回空指针
+    inline decompress_buffer(decompress_buffer&& other) noexcept : data{::std::move(other.data)}, capacity{::std::exchange(other.capacity, 0)}
+    {}
+
+    inline decompress_buffer& operator=(decompress_buffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            data = ::std::move(other.data);
+            capacity = ::std::exchange(other.capacity, 0);
+        }
+        return *this;
+    }
+
+    /// <summary>
+    /// 扩容到至少 size 字节并保留前 keep 字节；新缓冲区不初始化
+    /// </summary>
+    inline bool reserve(::std::size_t size, ::std::size_t keep) noexcept
+    {
+        if (size <= capacity)
+            return true;
+        ::std::unique_ptr<::std::byte[]> next{new (::std::nothrow) ::std::byte[size]};
+        if (!next)
+            return false;
+        if (keep != 0)
+            ::std::memcpy(next.get(), data.get(), keep);
+        data = ::std::move(next);
+        capacity = size;
+        return true;
+    }
+};
+
+// skipper
+
+/// <summary>
+/// 各 tag 的 payload 固定长度，0 表示变长
+/// </summary>
+inline constexpr ::std::array<::std::uint8_t, 13> nbt_payload_fixed_size{0, 1, 2, 4, 8, 4, 8, 0, 0, 0, 0, 0, 0};
+
+/// <summary>
+/// 与原版一致的最大嵌套深度
+/// </summary>
+inline constexpr ::std::size_t nbt_max_depth = 512;
+
+/// <summary>
+/// 跳过一个类型为 tag 的 payload（不含 tag id 与名称），不构造任何对象。
+/// 定长元素的 list 与各种 array 只读取长度字段后整体跳过；嵌套的 list/compound 用显式栈迭代，不会因恶意输入爆栈。
+/// </summary>
+template<::std::endian nbt_endian = ::std::endian::big>
+inline bool skip_payload(nbt_tag_type tag, ::std::byte const*& current_pos, ::std::byte const* end, nbt_error& error_code) noexcept
+{
+    struct frame
+    {
+        nbt_tag_type element;  // tag_end 表示 compound
+        ::std::uint32_t remaining;
+    };
+    frame frames[nbt_max_depth];
+    ::std::size_t depth{0};
+    auto pos{current_pos};
+
+    auto const need{[&](::std::size_t length) {
+        if (static_cast<::std::size_t>(end - pos) < length) [[unlikely]]
+        {
+            error_code = nbt_error::end_of_file;
+            return false;
+        }
+        return true;
+    }};
+    auto const invalid{[&]() {
+        error_code = nbt_error::invalid;
+        return false;
+    }};
+    auto const push{[&](nbt_tag_type element, ::std::uint32_t remaining) {
+        if (depth == nbt_max_depth) [[unlikely]]
+            return invalid();
+        frames[depth++] = frame{element, remaining};
+        return true;
+    }};
+
+    while (true)
+    {
+        switch (tag)
+        {
+            case nbt_tag_type::tag_byte:
+            case nbt_tag_type::tag_short:
+            case nbt_tag_type::tag_int:
+            case nbt_tag_type::tag_long:
+            case nbt_tag_type::tag_float:
+            case nbt_tag_type::tag_double:
+            {
+                if (!need(nbt_payload_fixed_size[tag]))
+                    return false;
+                pos += nbt_payload_fixed_size[tag];
+                break;
+            }
+            case nbt_tag_type::tag_string:
+            {
+                if (!need(2))
+                    return false;
+                auto const len{endian_get<::std::uint16_t, nbt_endian>(pos)};
+                pos += 2;
+                if (!need(len))
+                    return false;
+                pos += len;
+                break;
+            }
+            case nbt_tag_type::tag_byte_array:
+            case nbt_tag_type::tag_int_array:
+            case nbt_tag_type::tag_long_array:
+            {
+                if (!need(4))
+                    return false;
+                auto const len{endian_get<nbt_int, nbt_endian>(pos)};
+                pos += 4;
+                if (len < 0) [[unlikely]]
+                    return invalid();
+                auto const element_size{tag == nbt_tag_type::tag_byte_array ? 1 : (tag == nbt_tag_type::tag_int_array ? 4 : 8)};
+                auto const bytes{static_cast<::std::size_t>(len) * element_size};
+                if (!need(bytes))
+                    return false;
+                pos += bytes;
+                break;
+            }
+            case nbt_tag_type::tag_list:
+            {
+                if (!need(5))
+                    return false;
+                auto const element{static_cast<nbt_tag_type>(*pos)};
+                auto const len{endian_get<nbt_int, nbt_endian>(pos + 1)};
+                pos += 5;
+                if (len < 0 || element > nbt_tag_type::tag_long_array || (element == nbt_tag_type::tag_end && len != 0)) [[unlikely]]
+                    return invalid();
+                if (len == 0)
+                    break;
+                if (auto const element_size{nbt_payload_fixed_size[element]}; element_size != 0)
+                {
+                    // 定长元素：一次乘法跳过整个 list
+                    auto const bytes{static_cast<::std::size_t>(len) * element_size};
+                    if (!need(bytes))
+                        return false;
+                    pos += bytes;
+                }
+                else if (!push(element, static_cast<::std::uint32_t>(len)))
+                {
+                    return false;
+                }
+                break;
+            }
+            case nbt_tag_type::tag_compound:
+            {
+                if (!push(nbt_tag_type::tag_end, 0))
+                    return false;
+                break;
+            }
+            default:
+                return invalid();
+        }
+
+        // 找到下一个需要跳过的 payload
+        while (true)
+        {
+            if (depth == 0)
+            {
+                current_pos = pos;
+                return true;
+            }
+            auto& top{frames[depth - 1]};
+            if (top.element == nbt_tag_type::tag_end)
+            {
+                if (!need(1))
+                    return false;
+                auto const next{static_cast<nbt_tag_type>(*pos)};
+                pos += 1;
+                if (next == nbt_tag_type::tag_end)
+                {
+                    depth--;
+                    continue;
+                }
+                if (!need(2))
+                    return false;
+                auto const name_len{endian_get<::std::uint16_t, nbt_endian>(pos)};
+                pos += 2;
+                if (!need(name_len))
+                    return false;
+                pos += name_len;
+                tag = next;
+                break;
+            }
+            else
+            {
+                if (top.remaining == 0)
+                {
+                    depth--;
+                    continue;
+                }
+                top.remaining--;
+                tag = top.element;
+                break;
+            }
+        }
+    }
+}
+
+namespace detail {
+inline constexpr ::std::uint64_t field_name_hash(::std::uint64_t seed, ::std::string_view name) noexcept
+{
+    ::std::uint64_t h{0xcbf29ce484222325ULL ^ seed};
+    for (auto c : name)
+    {
+        h ^= static_cast<::std::uint8_t>(c);
+        h *= 0x100000001b3ULL;
+    }
+    return h ^ (h >> 29);
+}
+
+/// <summary>
+/// compound T 的字段名完美哈希表：编译期搜索一个 seed 使所有字段名落入不同的槽
+/// </summary>
+template<typename T>
+struct field_name_table
+{
+    constexpr static ::std::size_t count = boost::pfr::tuple_size_v<T>;
+
+    constexpr static ::std::size_t table_size = ::std::bit_ceil(count * 2 < 2 ? ::std::size_t{2} : count * 2);
+
+    inline static consteval auto names()
+    {
+        return []<typename Ti, Ti... Is>(::std::integer_sequence<Ti, Is...>) {
+            return ::std::array<::std::string_view, count>{boost::pfr::get_name<Is, T>()...};
+        }(::std::make_index_sequence<count>{});
+    }
+
+    constexpr static ::std::array<::std::string_view, count> field_names = names();
+
+    inline static consteval ::std::uint64_t find_seed()
+    {
+        for (::std::uint64_t seed{0};; seed++)
+        {
+            ::std::array<bool, table_size> used{};
+            bool ok{true};
+            for (auto name : field_names)
+            {
+                auto const slot{field_name_hash(seed, name) & (table_size - 1)};
+                if (used[slot])
+                {
+                    ok = false;
+                    break;
+                }
+                used[slot] = true;
+            }
+            if (ok)
+                return seed;
+        }
+    }
+
+    constexpr static ::std::uint64_t seed = find_seed();
+
+    inline static consteval auto slots_impl()
+    {
+        ::std::array<::std::size_t, table_size> result{};
+        for (auto& r : result)
+            r = count;
+        for (::std::size_t i{0}; i < count; i++)
+            result[field_name_hash(seed, field_names[i]) & (table_size - 1)] = i;
+        return result;
+    }
+
+    constexpr static ::std::array<::std::size_t, table_size> slots = slots_impl();
+
+    /// <summary>
+    /// 返回字段下标，找不到时返回 count
+    /// </summary>
+    inline static ::std::size_t lookup(::std::string_view name) noexcept
+    {
+        auto const index{slots[field_name_hash(seed, name) & (table_size - 1)]};
+        if (index == count || field_names[index] != name)
+            return count;
+        return index;
+    }
+};
+
+/// <summary>
+/// 单个 payload 至少占用的字节数，用于在按运行时长度分配元素前确认输入足够长
+/// </summary>
+template<any_nbt T>
+inline consteval ::std::size_t minimal_payload_size() noexcept
+{
+    if constexpr (::std::integral<T> || ::std::floating_point<T>)
+        return sizeof(T);
+    else if constexpr (::std::same_as<T, nbt_string>)
+        return sizeof(::std::uint16_t);
+    else if constexpr (any_nbt_list_type<T>)
+        return 1 + sizeof(nbt_int);
+    else if constexpr (any_nbt_array_type<T>)
+        return sizeof(nbt_int);
+    else
+        return 1;
+}
+
+/// <summary>
+/// 取出分配上下文中的 resource，未提供时为 nullptr
+/// </summary>
+inline ::std::pmr::memory_resource* allocation_resource(auto& allocation) noexcept
+{
+    if constexpr (requires { allocation.resource; })
+        return allocation.resource;
+    else
+        return nullptr;
+}
+
+/// <summary>
+/// 容器使用 polymorphic_allocator 时改为从 resource 分配；已经使用该 resource 或 resource 为 nullptr 时不做任何事
+/// </summary>
+template<typename Container>
+inline void use_resource(Container& container, ::std::pmr::memory_resource* resource) noexcept
+{
+    if constexpr (::std::same_as<typename Container::allocator_type, ::std::pmr::polymorphic_allocator<typename Container::value_type>>)
+    {
+        // polymorphic_allocator 赋值时不传播，只能重新构造容器
+        if (resource != nullptr && container.get_allocator().resource() != resource)
+        {
+            ::std::destroy_at(::std::addressof(container));
+            ::std::construct_at(::std::addressof(container), resource);
+        }
+    }
+}
+
+/// <summary>
+/// 容器改为从 resource 分配后调整为 count 个元素。分配失败（例如调用方的 arena 不够大）时以 invalid 返回 false，
+/// 不让 bad_alloc 穿过 noexcept 的 deserialize
+/// </summary>
+template<typename Container>
+inline bool resize_from(Container& container, ::std::pmr::memory_resource* resource, ::std::size_t count, nbt_error& error_code) noexcept
+{
+    use_resource(container, resource);
+    try
+    {
+        container.resize(count);
+    }
+    catch (::std::bad_alloc const&)
+    {
+        error_code = nbt_error::invalid;
+        return false;
+    }
+    return true;
+}
+
+/// <summary>
+/// 类型中是否含有需要就地转换字节序的 view
+/// </summary>
+template<any_option Option, typename T>
+inline consteval bool has_inplace_view() noexcept
+{
+    if constexpr (any_nbt_view<T>)
+        return T::endian != Option::endian && sizeof(typename T::value_type) != 1;
+    else if constexpr (any_nbt_list<T> || any_nbt_dynamic_list<T>)
+        return has_inplace_view<Option, typename T::type>();
+    else if constexpr (any_nbt_compound<T>)
+        return []<::std::size_t... Is>(::std::index_sequence<Is...>) {
+            return (has_inplace_view<Option, boost::pfr::tuple_element_t<Is, T>>() || ... || false);
+        }(::std::make_index_sequence<boost::pfr::tuple_size_v<T>>{});
+    else
+        return false;
+}
+
+/// <summary>
+/// 解码成功后把本机字节序 view 引用的数据在缓冲区中就地转换
+/// </summary>
+template<any_option Option, typename T>
+inline void inplace_finalize(T& value) noexcept
+{
+    if constexpr (!has_inplace_view<Option, T>())
+    {
+        return;
+    }
+    else if constexpr (any_nbt_view<T>)
+    {
+        // 缓冲区由调用方以可写 span 传入，这里去掉 const 是安全的
+        auto const bytes{const_cast<::std::byte*>(value.data())};
+        byteswap_copy<sizeof(typename T::value_type)>(bytes, bytes, value.size());
+    }
+    else if constexpr (any_nbt_compound<T>)
+    {
+        [&]<::std::size_t... Is>(::std::index_sequence<Is...>) {
+            (inplace_finalize<Option>(boost::pfr::get<Is>(value)), ...);
+        }(::std::make_index_sequence<boost::pfr::tuple_size_v<T>>{});
+    }
+    else
+    {
+        for (auto& e : value)
+            inplace_finalize<Option>(e);
+    }
+}
+
+/// <summary>
+/// 不依赖固定布局、按 tag 逐项解析的解码器，是定长快速路径失败后的退路
+/// </summary>
+template<any_option Option>
+struct tolerant_decoder
+{
+    struct cursor
+    {
+        ::std::byte const* current_pos;
+        ::std::byte const* end;
+        ::std::pmr::memory_resource* resource;
+    };
+
+    inline static bool need(cursor& c, ::std::size_t length, nbt_error& error_code) noexcept
+    {
+        if (static_cast<::std::size_t>(c.end - c.current_pos) < length) [[unlikely]]
+        {
+            error_code = nbt_error::end_of_file;
+            return false;
+        }
+        return true;
+    }
+
+    template<typename T>
+    inline static bool read_number(T& value, cursor& c, nbt_error& error_code) noexcept
+    {
+        if (!need(c, sizeof(T), error_code))
+            return false;
+        value = endian_get<T, Option::endian>(c.current_pos);
+        c.current_pos += sizeof(T);
+        return true;
+    }
+
+    inline static bool read_name(::std::string_view& name, cursor& c, nbt_error& error_code) noexcept
+    {
+        ::std::uint16_t len{};
+        if (!read_number(len, c, error_code) || !need(c, len, error_code))
+            return false;
+        name = ::std::string_view{reinterpret_cast<char const*>(c.current_pos), len};
+        c.current_pos += len;
+        return true;
+    }
+
+    template<any_nbt T>
+    inline static bool read_payload(T& value, cursor& c, nbt_error& error_code) noexcept;
+
+    template<any_nbt_compound T, ::std::size_t I>
+    inline static bool read_member(T& value, nbt_tag_type tag, cursor& c, nbt_error& error_code) noexcept
+    {
+        using U = boost::pfr::tuple_element_t<I, T>;
+        if (tag != nbt_type_id<U>) [[unlikely]]
+        {
+            error_code = nbt_error::invalid;
+            return false;
+        }
+        return read_payload(boost::pfr::get<I>(value), c, error_code);
+    }
+
+    template<any_nbt_compound T>
+    using member_reader = bool (*)(T&, nbt_tag_type, cursor&, nbt_error&) noexcept;
+
+    template<any_nbt_compound T>
+    constexpr static auto member_readers = []<typename Ti, Ti... Is>(::std::integer_sequence<Ti, Is...>) {
+        return ::std::array<member_reader<T>, sizeof...(Is)>{&read_member<T, Is>...};
+    }(::std::make_index_sequence<boost::pfr::tuple_size_v<T>>{});
+
+    /// <summary>
+    /// 结构体的每个字段都必须出现；缺少字段时返回 invalid，而不是保留快速路径失败时留下的值
+    /// </summary>
+    template<any_nbt_compound T>
+    inline static bool read_compound(T& value, cursor& c, nbt_error& error_code) noexcept
+    {
+        ::std::array<bool, boost::pfr::tuple_size_v<T>> seen{};
+        while (true)
+        {
+            ::std::uint8_t tag{};
+            if (!read_number(tag, c, error_code))
+                return false;
+            if (tag == nbt_tag_type::tag_end)
+            {
+                if (::std::find(seen.begin(), seen.end(), false) != seen.end()) [[unlikely]]
+                {
+                    error_code = nbt_error::invalid;
+                    return false;
+                }
+                return true;
+            }
+            ::std::string_view name{};
+            if (!read_name(name, c, error_code))
+                return false;
+            auto const index{field_name_table<T>::lookup(name)};
+            if (index == field_name_table<T>::count)
+            {
+                // 结构体中没有对应字段，整体跳过
+                if (!skip_payload<Option::endian>(static_cast<nbt_tag_type>(tag), c.current_pos, c.end, error_code))
+                    return false;
+                continue;
+            }
+            if (!member_readers<T>[index](value, static_cast<nbt_tag_type>(tag), c, error_code))
+                return false;
+            seen[index] = true;
+        }
+    }
+
+    /// <summary>
+    /// 读取带 tag 与名称的根节点；list 元素作为根时没有头部，直接读取 payload。consumed 返回消耗的字节数
+    /// </summary>
+    template<any_nbt T>
+    inline static bool read_root(T& value, ::std::byte const* start, ::std::size_t length, ::std::size_t& consumed, ::std::pmr::memory_resource* resource, nbt_error& error_code) noexcept
+    {
+        cursor c{start, start + length, resource};
+        if constexpr (!Option::list_element_root)
+        {
+            ::std::uint8_t tag{};
+            ::std::string_view name{};
+            if (!read_number(tag, c, error_code) || !read_name(name, c, error_code))
+                return false;
+            if (tag != nbt_type_id<T>) [[unlikely]]
+            {
+                error_code = nbt_error::invalid;
+                return false;
+            }
+        }
+        if (!read_payload(value, c, error_code))
+            return false;
+        consumed = static_cast<::std::size_t>(c.current_pos - start);
+        return true;
+    }
+};
+
+template<any_option Option>
+template<any_nbt T>
+inline bool tolerant_decoder<Option>::read_payload(T& value, cursor& c, nbt_error& error_code) noexcept
+{
+    if constexpr (::std::integral<T> || ::std::floating_point<T>)
+    {
+        return read_number(value, c, error_code);
+    }
+    else if constexpr (::std::same_as<T, nbt_string>)
+    {
+        ::std::string_view name{};
+        if (!read_name(name, c, error_code))
+            return false;
+        value = nbt_string{reinterpret_cast<char8_t const*>(name.data()), name.size()};
+        return true;
+    }
+    else if constexpr (any_nbt_array<T>)
+    {
+        using V = T::value_type;
+        nbt_int len{};
+        if (!read_number(len, c, error_code))
+            return false;
+        if (len != static_cast<nbt_int>(::std::tuple_size_v<T>)) [[unlikely]]
+        {
+            error_code = nbt_error::invalid;
+            return false;
+        }
+        if (!need(c, sizeof(V) * ::std::tuple_size_v<T>, error_code))
+            return false;
+        endian_get_n<V, Option::endian>(value.data(), c.current_pos, value.size());
+        c.current_pos += sizeof(V) * value.size();
+        return true;
+    }
+    else if constexpr (any_nbt_runtime_array<T>)
+    {
+        using V = T::value_type;
+        nbt_int len{};
+        if (!read_number(len, c, error_code))
+            return false;
+        if (len < 0) [[unlikely]]
+        {
+            error_code = nbt_error::invalid;
+            return false;
+        }
+        if (!need(c, sizeof(V) * static_cast<::std::size_t>(len), error_code))
+            return false;
+        if constexpr (any_nbt_array_view<T>)
+        {
+            value = T{c.current_pos, static_cast<::std::size_t>(len)};
+        }
+        else
+        {
+            if (!resize_from(value, c.resource, static_cast<::std::size_t>(len), error_code)) [[unlikely]]
+                return false;
+            endian_get_n<V, Option::endian>(value.data(), c.current_pos, value.size());
+        }
+        c.current_pos += sizeof(V) * value.size();
+        return true;
+    }
+    else if constexpr (any_nbt_list_type<T>)
+    {
+        using V = T::type;
+        ::std::uint8_t tag{};
+        nbt_int len{};
+        if (!read_number(tag, c, error_code) || !read_number(len, c, error_code))
+            return false;
+        if constexpr (any_nbt_runtime_list<T>)
+        {
+            if (len < 0 || (len != 0 && tag != nbt_type_id<V>)) [[unlikely]]
+            {
+                error_code = nbt_error::invalid;
+                return false;
+            }
+            // 先按最小元素大小确认剩余输入足够，再分配
+            if (!need(c, minimal_payload_size<V>() * static_cast<::std::size_t>(len), error_code))
+                return false;
+            if constexpr (any_nbt_list_view<T>)
+            {
+                value = T{c.current_pos, static_cast<::std::size_t>(len)};
+                c.current_pos += sizeof(V) * value.size();
+                return true;
+            }
+            else if (!resize_from(value, c.resource, static_cast<::std::size_t>(len), error_code)) [[unlikely]]
+            {
+                return false;
+            }
+        }
+        else if (len != static_cast<nbt_int>(T::nbt_list_length) || (len != 0 && tag != nbt_type_id<V>)) [[unlikely]]
+        {
+            error_code = nbt_error::invalid;
+            return false;
+        }
+        if constexpr (!any_nbt_list_view<T>)
+        {
+            for (auto& e : value)
+            {
+                if (!read_payload(e, c, error_code))
+                    return false;
+            }
+        }
+        return true;
+    }
+    else
+    {
+        static_assert(any_nbt_compound<T>);
+        return read_compound(value, c, error_code);
+    }
+}
+}  // namespace detail
+}  // namespace na::nbt
+
+template<na::serializer::any_serialize_option Option, na::serializer::any_serializer_profile Profile, na::serializer::any_node_path Path>
+struct na::serializer::node<na::nbt::nbt, Option, Profile, Path>
+  : na::serializer::node_base<na::nbt::nbt, Option, Profile, Path>
+{
+    using this_type = na::serializer::node<na::nbt::nbt, Option, Profile, Path>;
+
+    struct type_helper
+    {
+        template<typename Type, size_type Index>
+        inline static consteval auto type_impl_at()
+        {
+            static_assert(Index <= Path::size);
+            if constexpr (Index == Path::size)
+            {
+                return Type{};
+            }
+            else
+            {
+                using Now = Path::template at<Index>;
+                if constexpr (Now::has_guide)
+                {
+                    return type_impl_at<typename Now::type_guide, Index + 1>();
+                }
+                else
+                {
+                    constexpr size_type I0{Now::index};
+                    if constexpr (na::nbt::any_nbt_compound<Type>)
+                    {
+                        static_assert(I0 < boost::pfr::tuple_size_v<Type>, "nbt_index out of range");
+                        using U = boost::pfr::tuple_element_t<I0, Type>;
+                        return type_impl_at<U, Index + 1>();
+                    }
+                    else
+                    {
+                        static_assert(I0 < Type::nbt_list_length, "nbt_index out of range");
+                        return type_impl_at<typename Type::value_type, Index + 1>();
+                    }
+                }
+            }
+        }
+
+        inline static consteval auto type_impl()
+        {
+            return type_impl_at<typename Path::root, 0>();
+        }
+    };
+
+    using type = decltype(type_helper::type_impl());
+
+    constexpr static bool serializable = na::nbt::any_nbt<type>;
+
+    /// <summary>
+    /// 变长 list/array 的元素个数只有运行时才知道，总是作为 primitive 处理，元素在 deserialize_all/serialize_all 中逐个展开
+    /// </summary>
+    constexpr static bool dynamic = na::nbt::any_nbt_runtime_length<type>;
+
+    // 本机字节序的 view 只能用于 deserialize_inplace，由它就地转换
+    static_assert([]() {
+        if constexpr (na::nbt::any_nbt_view<type>)
+            return type::endian == Option::endian || type::endian == ::std::endian::native;
+        else
+            return true;
+    }(), "view endian must match the serializer option or be native");
+
+    constexpr static bool composite = na::nbt::any_complex_nbt<type> && !dynamic;
+
+    constexpr static bool primitive = na::nbt::any_simple_nbt<type> || dynamic;
+
+    struct size_helper
+    {
+        inline static consteval size_type size_impl()
+        {
+            using T = type;
+            if constexpr (na::nbt::any_nbt_compound<T>)
+                return boost::pfr::tuple_size_v<T>;
+            else if constexpr (na::nbt::any_complex_nbt_list<T>)
+                return T::nbt_list_length;
+            else
+                return 0;
+        }
+    };
+
+    constexpr static size_type size = size_helper::size_impl();
+
+    struct data_helper
+    {
+        template<typename T>
+        inline static consteval bool payload_memory_compatible_impl()
+        {
+            if constexpr (na::nbt::any_complex_nbt<T> || na::nbt::any_nbt_runtime_length<T>)
+            {
+                return false;  // not used
+            }
+            else if constexpr (::std::is_arithmetic_v<T>)
+            {
+                // 单字节数值没有字节序，大端模式下同样可以直接复制
+                return Option::endian == ::std::endian::native || sizeof(T) == 1;
+            }
+            else if constexpr (na::nbt::any_nbt_array<T>)
+            {
+                return payload_memory_compatible_impl<typename T::value_type>();
+            }
+            else if constexpr (na::nbt::any_nbt_list<T>)
+            {
+                return payload_memory_compatible_impl<typename T::type>();
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        inline constexpr static bool prepend_fixed_size()
+        {
+            return true;
+        }
+
+        template<typename T>
+        inline constexpr static bool payload_fixed_size()
+        {
+            if constexpr (na::nbt::any_nbt_runtime_length<T>)
+            {
+                return false;
+            }
+            if constexpr (na::nbt::any_complex_nbt<T>)
+            {
+                return false;  // not used
+            }
+            if constexpr (::std::same_as<T, na::nbt::nbt_string>)
+            {
+                return false;
+            }
+            else if constexpr (na::nbt::any_nbt_list<T>)
+            {
+                return payload_fixed_size<typename T::type>();
+            }
+            else
+            {
+                return true;
+            }
+        }
+
+        inline constexpr static bool postpend_fixed_size()
+        {
+            return true;
+        }
+
+        inline constexpr static size_type prepend_minimal_size()
+        {
+            using Type = type;
+            if constexpr (Path::size == 0 && !Option::list_element_root)
+            {
+                if constexpr (na::nbt::any_nbt_list_type<Type>)
+                    return 1 + 2 + 1 + 4;
+                else if constexpr (na::nbt::any_nbt_array_type<Type>)
+                    return 1 + 2 + 4;
+                else
+                    return 1 + 2;
+            }
+            else if constexpr (Path::size == 0)  // list 中的元素
+            {
+                if constexpr (na::nbt::any_nbt_list_type<Type>)
+                    return 1 + 4;
+                else if constexpr (na::nbt::any_nbt_array_type<Type>)
+                    return 4;
+                else
+                    return 0;
+            }
+            else
+            {
+                using ParentType = node_parent<this_type>::type;
+                constexpr auto Index = path_last<Path>::index;
+                if constexpr (na::nbt::any_nbt_compound<ParentType>)
+                {
+                    if constexpr (na::nbt::any_nbt_list_type<Type>)
+                        return static_cast<::std::size_t>(1) + 2 + boost::pfr::get_name<Index, ParentType>().size() + 1 + 4;
+                    else if constexpr (na::nbt::any_nbt_array_type<Type>)
+                        return static_cast<::std::size_t>(1) + 2 + boost::pfr::get_name<Index, ParentType>().size() + 4;
+                    else
+                        return static_cast<::std::size_t>(1) + 2 + boost::pfr::get_name<Index, ParentType>().size();
+                }
+                else  // list
+                {
+                    static_assert(na::nbt::any_complex_nbt_list<ParentType>);
+                    if constexpr (na::nbt::any_nbt_list_type<Type>)
+                        return 1 + 4;
+                    else if constexpr (na::nbt::any_nbt_array_type<Type>)
+                        return 4;
+                    else
+                        return 0;
+                }
+            }
+        }
+
+        template<typename T>
+        inline constexpr static size_type payload_minimal_size()
+        {
+            if constexpr (na::nbt::any_nbt_runtime_length<T>)
+            {
+                return 0;
+            }
+            if constexpr (na::nbt::any_complex_nbt<T>)
+            {
+                return 0;  // not used
+            }
+            if constexpr (std::integral<T> || std::floating_point<T>)
+            {
+                return sizeof(T);
+            }
+            else if constexpr (na::nbt::any_nbt_array<T>)
+            {
+                using U = T::value_type;
+                return ::std::tuple_size_v<T> * sizeof(U);
+            }
+            else if constexpr (std::same_as<T, na::nbt::nbt_string>)
+            {
+                return 2 /* name length */;
+            }
+            else if constexpr (na::nbt::any_nbt_list<T>)
             {
                 return T::nbt_list_length * payload_minimal_size<typename T::type>();
             }
@@ -447,14 +1862,112 @@ struct na::serializer::node<na::nbt::nbt, Option, Profile, Path>
 
     constexpr static size_type prepend_minimal_size = data_helper::prepend_minimal_size();
 
-    constexpr static size_type payload_minimal_size = data_helper::template payload_minimal_size<type>();
+    constexpr static size_type payload_minimal_size = data_helper::template payload_minimal_size<type>();
+
+    constexpr static size_type postpend_minimal_size = data_helper::postpend_minimal_size();
+
+    /// <summary>
+    /// prepend 中编译期可确定的前缀长度；变长 list 的元素类型与长度、变长 array 的长度只能在运行时读写
+    /// </summary>
+    constexpr static size_type prepend_constant_size = prepend_minimal_size - (na::nbt::any_nbt_runtime_list<type> ? 1 + 4 : (na::nbt::any_nbt_runtime_array<type> ? 4 : 0));
+
+    struct header_helper
+    {
+        template<::std::size_t N>
+        struct writer
+        {
+            ::std::array<::std::byte, N> bytes{};
+            size_type position{0};
+
+            template<::std::integral U>
+            inline constexpr void put(U const value)
+            {
+                using UU = ::std::make_unsigned_t<U>;
+                auto const v{static_cast<UU>(value)};
+                for (size_type i{0}; i < sizeof(U); i++)
+                {
+                    size_type const shift{Option::endian == ::std::endian::big ? (sizeof(U) - 1 - i) * 8 : i * 8};
+                    bytes[position++] = static_cast<::std::byte>(static_cast<::std::uint8_t>(v >> shift));
+                }
+            }
+
+            inline constexpr void put_name(::std::string_view name)
+            {
+                put(static_cast<::std::uint16_t>(name.size()));
+                for (auto c : name)
+                {
+                    bytes[position++] = static_cast<::std::byte>(c);
+                }
+            }
+        };
+
+        inline static consteval auto prepend_bytes_impl()
+        {
+            using Type = type;
+            writer<prepend_constant_size> w{};
+            if constexpr (Path::size == 0 && !Option::list_element_root)
+            {
+                w.put(static_cast<::std::uint8_t>(na::nbt::nbt_type_id<Type>));
+                w.put_name(::std::string_view{});
+            }
+            else if constexpr (Path::size != 0)
+            {
+                using ParentType = node_parent<this_type>::type;
+                if constexpr (na::nbt::any_nbt_compound<ParentType>)
+                {
+                    w.put(static_cast<::std::uint8_t>(na::nbt::nbt_type_id<Type>));
+                    w.put_name(boost::pfr::get_name<path_last<Path>::index, ParentType>());
+                }
+            }
+            if constexpr (na::nbt::any_nbt_list<Type>)
+            {
+                w.put(static_cast<::std::uint8_t>(na::nbt::nbt_type_id<typename Type::type>));
+                w.put(static_cast<na::nbt::nbt_int>(Type::nbt_list_length));
+            }
+            else if constexpr (na::nbt::any_nbt_array<Type>)
+            {
+                w.put(static_cast<na::nbt::nbt_int>(::std::tuple_size_v<Type>));
+            }
+            return w.bytes;
+        }
+
+        inline static consteval auto postpend_bytes_impl()
+        {
+            writer<postpend_minimal_size> w{};
+            if constexpr (na::nbt::any_nbt_compound<type>)
+            {
+                w.put(static_cast<::std::uint8_t>(na::nbt::nbt_tag_type::tag_end));
+            }
+            return w.bytes;
+        }
+    };
+
+    /// <summary>
+    /// prepend 的常量字节（tag id、名称长度、名称、定长 list 的元素类型与长度、定长 array 的长度）都在编译期确定
+    /// </summary>
+    constexpr static ::std::array<::std::byte, prepend_constant_size> prepend_bytes = header_helper::prepend_bytes_impl();
+
+    constexpr static ::std::array<::std::byte, postpend_minimal_size> postpend_bytes = header_helper::postpend_bytes_impl();
 
-    constexpr static size_type postpend_minimal_size = data_helper::postpend_minimal_size();
+    /// <summary>
+    /// 成员指针对应的字段下标：在编译期比较 member_probe 中成员指针指向的地址与 pfr::get 得到的各字段地址
+    /// </summary>
+    template<auto Member>
+    requires(na::nbt::any_nbt_compound<type>) constexpr static size_type member_index = []() consteval {
+        static_assert(::std::same_as<decltype(Member), ::std::remove_cvref_t<decltype(na::nbt::detail::member_probe<type>.*Member)> type::*>, "member pointer does not belong to this compound");
+        auto const& object{na::nbt::detail::member_probe<type>};
+        auto const target{static_cast<void const*>(::std::addressof(object.*Member))};
+        return []<::std::size_t... Is>(void const* t, auto const& o, ::std::index_sequence<Is...>) consteval {
+            size_type index{sizeof...(Is)};
+            ((static_cast<void const*>(::std::addressof(boost::pfr::get<Is>(o))) == t ? (index = Is, true) : false) || ...);
+            return index;
+        }(target, object, ::std::make_index_sequence<boost::pfr::tuple_size_v<type>>{});
+    }();
 
     struct payload_reference_helper
     {
         template<na::nbt::any_complex_nbt T, typename E, any_node_index I0, any_node_index... Is>
-        inline constexpr static auto& payload_reference_impl(T& value, node_path<E, I0, Is...>)
+        inline constexpr static auto& payload_reference_impl(auto& value, node_path<E, I0, Is...>)
         {
             constexpr size_type index{I0::index};
             if constexpr (sizeof...(Is) == 0)
@@ -492,7 +2005,16 @@ struct na::serializer::node<na::nbt::nbt, Option, Profile, Path>
 
     inline constexpr static auto& payload_reference(auto& value)
     {
-        if constexpr (Path::size == 0)
+        if constexpr (any_subtree_reference<decltype(value)>)
+        {
+            using Base = ::std::remove_cvref_t<decltype(value)>::path;
+            static_assert(::std::same_as<typename Path::template take_first_n<Base::size>, Base>, "node is not in the subtree");
+            if constexpr (Base::size == Path::size)
+                return value.value;
+            else
+                return payload_reference_helper::template payload_reference_impl<::std::remove_cvref_t<decltype(value.value)>>(value.value, typename Path::template drop_first_n<Base::size>{});
+        }
+        else if constexpr (Path::size == 0)
         {
             return value;
         }
@@ -506,8 +2028,24 @@ struct na::serializer::node<na::nbt::nbt, Option, Profile, Path>
 
     using deserialize_context = no_context;
 
+    using root_node = node<na::nbt::nbt, Option, Profile, node_path<typename Path::root>>;
+
+    // 非根节点的头部由根节点与变长节点处的 skeleton 校验覆盖，反序列化时不需要单独的 step
+    constexpr static bool deserialize_prepend_noop = Path::size != 0;
+
+    constexpr static bool deserialize_postpend_noop = true;
+
     inline constexpr static bool deserialize_prepend(auto& value, ::std::byte const* start, ::std::size_t& offset, ::std::size_t reversed, deserialize_context& context, na::nbt::nbt_error& error_code)
     {
+        if constexpr (Path::size == 0)
+        {
+            // 在执行任何 step 之前一次性校验第一段的所有 tag id 与名称
+            if (!skeleton<this_type>::template matches<0>(start, offset)) [[unlikely]]
+            {
+                error_code = na::nbt::nbt_error::invalid;
+                return false;
+            }
+        }
         return true;
     }
 
@@ -516,14 +2054,174 @@ struct na::serializer::node<na::nbt::nbt, Option, Profile, Path>
         return true;
     }
 
-    inline constexpr static bool deserialize_all(auto& value, ::std::byte const* start, ::std::size_t& offset, ::std::size_t reversed, na::nbt::nbt_error& error_code)
+    /// <summary>
+    /// 定长快速路径失败后由 deserialize 调用，仅对根节点且开启 field_order_tolerant 时生效
+    /// </summary>
+    inline static bool deserialize_fallback(auto& value, ::std::byte const* start, ::std::size_t length, ::std::size_t& consumed, auto& allocation, na::nbt::nbt_error& error_code) noexcept
+    {
+        static_assert(Path::size == 0);
+        if constexpr (!Option::field_order_tolerant)
+        {
+            return false;
+        }
+        else
+        {
+            error_code = na::nbt::nbt_error::ok;
+            return na::nbt::detail::tolerant_decoder<Option>::read_root(value, start, length, consumed, na::nbt::detail::allocation_resource(allocation), error_code);
+        }
+    }
+
+    /// <summary>
+    /// deserialize_inplace 成功后调用，就地转换本机字节序 view 引用的数据
+    /// </summary>
+    inline static void deserialize_inplace_finalize(auto& value) noexcept
+    {
+        static_assert(Path::size == 0);
+        na::nbt::detail::inplace_finalize<Option>(value);
+    }
+
+    /// <summary>
+    /// 用 skip_payload 跳过变长 payload，不构造任何对象，然后校验其后一段的常量字节
+    /// </summary>
+    inline static bool deserialize_skip(::std::byte const* start, ::std::size_t& offset, ::std::size_t reversed, na::nbt::nbt_error& error_code) noexcept
+    {
+        static_assert(skeleton_ends_segment<this_type>);
+        // list 的元素类型与长度、array 的长度在 NBT 中属于 payload，这里从它们开始跳过
+        constexpr size_type payload_header_size{na::nbt::any_nbt_list_type<type> ? 1 + 4 : (na::nbt::any_nbt_array_type<type> ? 4 : 0)};
+        auto current_pos{start + payload_minimal_offset<this_type> - payload_header_size + offset};
+        auto const end{start + total_minimal_size<root_node> + reversed};
+        if (!na::nbt::skip_payload<Option::endian>(na::nbt::nbt_type_id<type>, current_pos, end, error_code)) [[unlikely]]
+        {
+            return false;
+        }
+        auto const next{static_cast<::std::size_t>(current_pos - start) - postpend_minimal_offset<this_type>};
+        if (next > reversed) [[unlikely]]
+        {
+            error_code = na::nbt::nbt_error::end_of_file;
+            return false;
+        }
+        offset = next;
+        if (!skeleton<root_node>::template matches<skeleton_breaks_before<this_type> + 1>(start, offset)) [[unlikely]]
+        {
+            error_code = na::nbt::nbt_error::invalid;
+            return false;
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// 读取变长 list/array 的元素，payload 全部计入 offset；调用前 offset 不超过 reversed
+    /// </summary>
+    inline static bool deserialize_dynamic(auto& ref, ::std::byte const* start, ::std::size_t& offset, ::std::size_t reversed, auto& allocation, na::nbt::nbt_error& error_code)
+    {
+        using T = type;
+        using V = T::value_type;
+        constexpr auto minimal_offset{payload_minimal_offset<this_type>};
+        auto const length_pos{start + minimal_offset + offset - sizeof(na::nbt::nbt_int)};
+        auto const len{na::nbt::endian_get<na::nbt::nbt_int, Option::endian>(length_pos)};
+        if (len < 0) [[unlikely]]
+        {
+            error_code = na::nbt::nbt_error::invalid;
+            return false;
+        }
+        if constexpr (na::nbt::any_nbt_runtime_list<T>)
+        {
+            auto const tag{na::nbt::endian_get<::std::uint8_t, Option::endian>(length_pos - 1)};
+            if (len != 0 && tag != na::nbt::nbt_type_id<V>) [[unlikely]]
+            {
+                error_code = na::nbt::nbt_error::invalid;
+                return false;
+            }
+        }
+        // 先按最小元素大小确认剩余输入足够，再分配
+        auto const count{static_cast<::std::size_t>(len)};
+        if (count * na::nbt::detail::minimal_payload_size<V>() > reversed - offset) [[unlikely]]
+        {
+            error_code = na::nbt::nbt_error::end_of_file;
+            return false;
+        }
+        auto current_pos{start + minimal_offset + offset};
+        if constexpr (na::nbt::any_nbt_view<T>)
+        {
+            static_assert(T::endian == Option::endian || any_inplace_context<decltype(allocation)>, "native endian views require deserialize_inplace");
+            // 只记录位置，元素在访问时才转换；就地模式下由 deserialize_inplace_finalize 统一转换
+            ref = T{current_pos, count};
+            offset += count * sizeof(V);
+        }
+        else
+        {
+            if (!na::nbt::detail::resize_from(ref, na::nbt::detail::allocation_resource(allocation), count, error_code)) [[unlikely]]
+                return false;
+            if constexpr (::std::integral<V> || ::std::floating_point<V>)
+            {
+                na::nbt::endian_get_n<V, Option::endian>(ref.data(), current_pos, count);
+                offset += count * sizeof(V);
+            }
+            else if constexpr (::std::same_as<V, na::nbt::nbt_string>)
+            {
+                for (auto& e : ref)
+                {
+                    if (sizeof(::std::uint16_t) > reversed - offset) [[unlikely]]
+                    {
+                        error_code = na::nbt::nbt_error::end_of_file;
+                        return false;
+                    }
+                    auto const str_len{na::nbt::endian_get<::std::uint16_t, Option::endian>(current_pos)};
+                    offset += sizeof(::std::uint16_t) + str_len;
+                    if (offset > reversed) [[unlikely]]
+                    {
+                        error_code = na::nbt::nbt_error::end_of_file;
+                        return false;
+                    }
+                    e = ::std::u8string_view(reinterpret_cast<char8_t const*>(current_pos + sizeof(::std::uint16_t)), str_len);
+                    current_pos += sizeof(::std::uint16_t) + str_len;
+                }
+            }
+            else
+            {
+                // 复杂元素以无头部的根节点递归反序列化
+                for (auto& e : ref)
+                {
+                    ::std::size_t consumed{0};
+                    if (!na::serializer::deserialize<na::nbt::nbt, na::nbt::element_option<Option>>(e, ::std::span<::std::byte const>{current_pos, reversed - offset}, consumed, allocation, error_code)) [[unlikely]]
+                    {
+                        // 剩余输入不足元素的最小长度时没有错误码，区分为输入不完整
+                        using element_node = node<na::nbt::nbt, na::nbt::element_option<Option>, serializer_profile<operations::serialize>, node_path<V>>;
+                        if (error_code == na::nbt::nbt_error::ok)
+                            error_code = reversed - offset < total_minimal_size<element_node> ? na::nbt::nbt_error::end_of_file : na::nbt::nbt_error::invalid;
+                        return false;
+                    }
+                    offset += consumed;
+                    current_pos += consumed;
+                }
+            }
+        }
+        return true;
+    }
+
+    inline constexpr static bool deserialize_all(auto& value, ::std::byte const* start, ::std::size_t& offset, ::std::size_t reversed, auto& allocation, na::nbt::nbt_error& error_code)
     {
-        static_assert(::std::same_as<::std::remove_reference_t<decltype(value)>, typename Path::root>);
+        static_assert(::std::same_as<::std::remove_reference_t<decltype(value)>, typename Path::root> || any_subtree_reference<decltype(value)>);
         constexpr auto minimal_offset{payload_minimal_offset<this_type>};
         auto& ref{payload_reference(value)};
         using T = type;
 
-        if constexpr (na::nbt::any_complex_nbt<T>)
+        if constexpr (Path::size == 0)
+        {
+            if (!skeleton<this_type>::template matches<0>(start, offset)) [[unlikely]]
+            {
+                error_code = na::nbt::nbt_error::invalid;
+                return false;
+            }
+        }
+        if constexpr (dynamic)
+        {
+            if (!deserialize_dynamic(ref, start, offset, reversed, allocation, error_code)) [[unlikely]]
+            {
+                return false;
+            }
+        }
+        else if constexpr (na::nbt::any_complex_nbt<T>)
         {
             return true;
         }
@@ -533,14 +2231,8 @@ struct na::serializer::node<na::nbt::nbt, Option, Profile, Path>
         }
         else if constexpr (na::nbt::any_nbt_array<T>)
         {
-            constexpr auto len{::std::tuple_size_v<T>};
             using V = T::value_type;
-            auto current_pos{start + minimal_offset + offset};
-            for (::std::int32_t _index = 0; _index < len; _index++)
-            {
-                ref[_index] = na::nbt::endian_get<V, Option::endian>(current_pos);
-                current_pos += sizeof(V);
-            }
+            na::nbt::endian_get_n<V, Option::endian>(ref.data(), start + minimal_offset + offset, ::std::tuple_size_v<T>);
         }
         else if constexpr (na::nbt::any_simple_nbt_list<T>)
         {
@@ -550,11 +2242,12 @@ struct na::serializer::node<na::nbt::nbt, Option, Profile, Path>
             {
                 for (::std::int32_t _index = 0; _index < len; _index++)
                 {
-                    auto current_pos{start + minimal_offset + offset};
+                    auto current_pos{start + minimal_offset + offset + _index * sizeof(::std::uint16_t)};
                     auto len{na::nbt::endian_get<::std::uint16_t, Option::endian>(current_pos)};
                     offset += len;
                     if (offset > reversed)
                     {
+                        error_code = na::nbt::nbt_error::end_of_file;
                         return false;
                     }
                     ref[_index] = ::std::u8string_view(reinterpret_cast<char8_t const*>(current_pos + sizeof(::std::uint16_t)), len);
@@ -562,12 +2255,7 @@ struct na::serializer::node<na::nbt::nbt, Option, Profile, Path>
             }
             else
             {
-                auto current_pos{start + minimal_offset + offset};
-                for (::std::int32_t _index = 0; _index < len; _index++)
-                {
-                    ref[_index] = na::nbt::endian_get<V, Option::endian>(current_pos);
-                    current_pos += sizeof(V);
-                }
+                na::nbt::endian_get_n<V, Option::endian>(ref.data(), start + minimal_offset + offset, len);
             }
         }
         else if constexpr (std::same_as<T, na::nbt::nbt_string>)
@@ -577,10 +2265,20 @@ struct na::serializer::node<na::nbt::nbt, Option, Profile, Path>
             offset += len;
             if (offset > reversed)
             {
+                error_code = na::nbt::nbt_error::end_of_file;
                 return false;
             }
             ref = ::std::u8string_view(reinterpret_cast<char8_t const*>(current_pos + sizeof(::std::uint16_t)), len);
         }
+        if constexpr (skeleton_ends_segment<this_type>)
+        {
+            // 变长 payload 之后的常量字节位置已确定，校验下一段
+            if (!skeleton<root_node>::template matches<skeleton_breaks_before<this_type> + 1>(start, offset)) [[unlikely]]
+            {
+                error_code = na::nbt::nbt_error::invalid;
+                return false;
+            }
+        }
         return true;
     }
 
@@ -593,7 +2291,28 @@ struct na::serializer::node<na::nbt::nbt, Option, Profile, Path>
 
     inline constexpr static size_type payload_extra_size(auto& value)
     {
-        if constexpr (nbt::any_complex_nbt<type>)
+        if constexpr (dynamic)
+        {
+            using V = type::value_type;
+            auto const& ref{payload_reference(value)};
+            if constexpr (::std::integral<V> || ::std::floating_point<V>)
+            {
+                return ref.size() * sizeof(V);
+            }
+            else
+            {
+                size_type result{0};
+                for (auto const& e : ref)
+                {
+                    if constexpr (::std::same_as<V, nbt::nbt_string>)
+                        result += sizeof(::std::uint16_t) + e.size();
+                    else
+                        result += na::serializer::serialized_size<nbt::nbt, nbt::element_option<Option>>(e);
+                }
+                return result;
+            }
+        }
+        else if constexpr (nbt::any_complex_nbt<type>)
             return 0;  // not used
         else if constexpr (payload_fixed_size)
             return 0;
@@ -615,6 +2334,7 @@ struct na::serializer::node<na::nbt::nbt, Option, Profile, Path>
                         {
                             result += self(e, self);
                         }
+                        return result;
                     }
                     else
                     {
@@ -622,7 +2342,7 @@ struct na::serializer::node<na::nbt::nbt, Option, Profile, Path>
                         return value.size();
                     }
                 }};
-            return get_list_extra_size(value, get_list_extra_size);
+            return get_list_extra_size(payload_reference(value), get_list_extra_size);
         }
     }
 
@@ -633,65 +2353,344 @@ struct na::serializer::node<na::nbt::nbt, Option, Profile, Path>
 
     using serialize_context = no_context;
 
-    inline constexpr static void serialize_prepend(auto& value, ::std::byte const* start, serialize_context& context)
+    inline constexpr static bool serialize_prepend(auto const& value, ::std::byte* start, ::std::size_t base, ::std::size_t& offset, ::std::size_t reversed, serialize_context& context, na::nbt::nbt_error& error_code)
     {
-        using Type = type;
-        if constexpr (Path::size == 0)
+        if constexpr (prepend_constant_size != 0)
         {
-            if constexpr (na::nbt::any_nbt_list<Type>)
+            ::std::memcpy(start + (prepend_minimal_offset<this_type> + offset - base), prepend_bytes.data(), prepend_constant_size);
+        }
+        return true;
+    }
+
+    inline constexpr static bool serialize_postpend(auto const& value, ::std::byte* start, ::std::size_t base, ::std::size_t& offset, ::std::size_t reversed, serialize_context& context, na::nbt::nbt_error& error_code)
+    {
+        if constexpr (postpend_minimal_size != 0)
+        {
+            ::std::memcpy(start + (postpend_minimal_offset<this_type> + offset - base), postpend_bytes.data(), postpend_minimal_size);
+        }
+        return true;
+    }
+
+    inline constexpr static bool serialize_string(na::nbt::nbt_string const str, ::std::byte* current_pos, ::std::size_t& offset, ::std::size_t reversed, na::nbt::nbt_error& error_code)
+    {
+        auto const len{str.size()};
+        if (len > 0xFFFF) [[unlikely]]
+        {
+            error_code = na::nbt::nbt_error::invalid;
+            return false;
+        }
+        offset += len;
+        if (offset > reversed) [[unlikely]]
+        {
+            error_code = na::nbt::nbt_error::end_of_file;
+            return false;
+        }
+        na::nbt::endian_set<::std::uint16_t, Option::endian>(current_pos, static_cast<::std::uint16_t>(len));
+        ::std::memcpy(current_pos + sizeof(::std::uint16_t), str.data(), len);
+        return true;
+    }
+
+    /// <summary>
+    /// 写出变长 list/array 的元素类型、长度与全部元素
+    /// </summary>
+    inline static bool serialize_dynamic(auto const& ref, ::std::byte* start, ::std::size_t base, ::std::size_t& offset, ::std::size_t reversed, na::nbt::nbt_error& error_code)
+    {
+        using T = type;
+        using V = T::value_type;
+        constexpr auto minimal_offset{payload_minimal_offset<this_type>};
+        if (ref.size() > static_cast<::std::size_t>(::std::numeric_limits<na::nbt::nbt_int>::max())) [[unlikely]]
+        {
+            error_code = na::nbt::nbt_error::invalid;
+            return false;
+        }
+        auto const length_pos{start + (minimal_offset + offset - base - sizeof(na::nbt::nbt_int))};
+        if constexpr (na::nbt::any_nbt_runtime_list<T>)
+        {
+            na::nbt::endian_set<::std::uint8_t, Option::endian>(length_pos - 1, static_cast<::std::uint8_t>(ref.empty() ? na::nbt::nbt_tag_type::tag_end : na::nbt::nbt_type_id<V>));
+        }
+        na::nbt::endian_set<na::nbt::nbt_int, Option::endian>(length_pos, static_cast<na::nbt::nbt_int>(ref.size()));
+        auto current_pos{start + (minimal_offset + offset - base)};
+        if constexpr (::std::integral<V> || ::std::floating_point<V>)
+        {
+            if (ref.size() * sizeof(V) > reversed - offset) [[unlikely]]
             {
+                error_code = na::nbt::nbt_error::end_of_file;
+                return false;
             }
-            // return 1 + 2 + 1 + 4;
-            else if constexpr (na::nbt::any_nbt_array<Type>)
+            if constexpr (na::nbt::any_nbt_view<T>)
             {
+                // 就地解码后的 view 已是本机字节序，需要转换回来
+                if constexpr (T::endian == Option::endian || sizeof(V) == 1)
+                    ::std::memcpy(current_pos, ref.data(), ref.size() * sizeof(V));
+                else
+                    na::nbt::detail::byteswap_copy<sizeof(V)>(current_pos, ref.data(), ref.size());
             }
-            // return 1 + 2 + 4;
             else
             {
+                na::nbt::endian_set_n<V, Option::endian>(current_pos, ref.data(), ref.size());
             }
-            // return 1 + 2;
+            offset += ref.size() * sizeof(V);
         }
-        else
+        else if constexpr (::std::same_as<V, na::nbt::nbt_string>)
         {
-            using ParentType = node_parent<this_type>::type;
-            constexpr auto Index = path_last<Path>::index;
-            if constexpr (na::nbt::any_nbt_compound<ParentType>)
+            for (auto const e : ref)
             {
-                if constexpr (na::nbt::any_nbt_list<Type>)
-                {
-                }
-                // return static_cast<::std::size_t>(1) + 2 + boost::pfr::get_name<Index, ParentType>().size() + 1 + 4;
-                else if constexpr (na::nbt::any_nbt_array<Type>)
+                offset += sizeof(::std::uint16_t);
+                if (offset > reversed) [[unlikely]]
                 {
+                    error_code = na::nbt::nbt_error::end_of_file;
+                    return false;
                 }
-                // return static_cast<::std::size_t>(1) + 2 + boost::pfr::get_name<Index, ParentType>().size() + 4;
-                else
+                if (!serialize_string(e, current_pos, offset, reversed, error_code)) [[unlikely]]
                 {
+                    return false;
                 }
-                // return static_cast<::std::size_t>(1) + 2 + boost::pfr::get_name<Index, ParentType>().size();
+                current_pos += sizeof(::std::uint16_t) + e.size();
             }
-            else  // list
+        }
+        else
+        {
+            for (auto const& e : ref)
             {
-                static_assert(na::nbt::any_complex_nbt_list<ParentType>);
-                if constexpr (na::nbt::any_nbt_list<Type>)
-                {
-                }
-                // return 1 + 4;
-                else if constexpr (na::nbt::any_nbt_array<Type>)
+                ::std::size_t written{0};
+                if (!na::serializer::serialize<na::nbt::nbt, na::nbt::element_option<Option>>(e, ::std::span<::std::byte>{current_pos, reversed - offset}, written, error_code)) [[unlikely]]
                 {
+                    return false;
                 }
-                // return 4;
-                else
+                offset += written;
+                current_pos += written;
+            }
+        }
+        return true;
+    }
+
+    inline constexpr static bool serialize_all(auto const& value, ::std::byte* start, ::std::size_t base, ::std::size_t& offset, ::std::size_t reversed, na::nbt::nbt_error& error_code)
+    {
+        static_assert(::std::same_as<::std::remove_cvref_t<decltype(value)>, typename Path::root>);
+        constexpr auto minimal_offset{payload_minimal_offset<this_type>};
+        auto const& ref{payload_reference(value)};
+        using T = type;
+
+        if constexpr (prepend_constant_size != 0)
+        {
+            ::std::memcpy(start + (prepend_minimal_offset<this_type> + offset - base), prepend_bytes.data(), prepend_constant_size);
+        }
+
+        if constexpr (dynamic)
+        {
+            if (!serialize_dynamic(ref, start, base, offset, reversed, error_code)) [[unlikely]]
+            {
+                return false;
+            }
+        }
+        else if constexpr (na::nbt::any_complex_nbt<T>)
+        {
+            return true;
+        }
+        else if constexpr (std::integral<T> || std::floating_point<T>)
+        {
+            na::nbt::endian_set<T, Option::endian>(start + (minimal_offset + offset - base), ref);
+        }
+        else if constexpr (na::nbt::any_nbt_array<T>)
+        {
+            using V = T::value_type;
+            na::nbt::endian_set_n<V, Option::endian>(start + (minimal_offset + offset - base), ref.data(), ::std::tuple_size_v<T>);
+        }
+        else if constexpr (na::nbt::any_simple_nbt_list<T>)
+        {
+            constexpr auto len{T::nbt_list_length};
+            using V = T::value_type;
+            if constexpr (std::same_as<V, na::nbt::nbt_string>)
+            {
+                for (::std::int32_t _index = 0; _index < len; _index++)
                 {
+                    auto current_pos{start + (minimal_offset + offset - base + _index * sizeof(::std::uint16_t))};
+                    if (!serialize_string(ref[_index], current_pos, offset, reversed, error_code)) [[unlikely]]
+                    {
+                        return false;
+                    }
                 }
-                // return 0;
             }
+            else
+            {
+                na::nbt::endian_set_n<V, Option::endian>(start + (minimal_offset + offset - base), ref.data(), len);
+            }
+        }
+        else if constexpr (std::same_as<T, na::nbt::nbt_string>)
+        {
+            if (!serialize_string(ref, start + (minimal_offset + offset - base), offset, reversed, error_code)) [[unlikely]]
+            {
+                return false;
+            }
+        }
+
+        if constexpr (postpend_minimal_size != 0)
+        {
+            ::std::memcpy(start + (postpend_minimal_offset<this_type> + offset - base), postpend_bytes.data(), postpend_minimal_size);
         }
+        return true;
+    }
+};
+
+namespace na::nbt {
+namespace detail {
+template<typename M>
+struct member_owner;
+template<typename M, typename C>
+struct member_owner<M C::*>
+{
+    using type = C;
+};
+
+template<any_option Option, typename T>
+using batch_root = na::serializer::node<nbt, Option, na::serializer::serializer_profile<na::serializer::operations::serialize>, na::serializer::node_path<T>>;
+
+struct batch_helper
+{
+    /// <summary>
+    /// 可以跨记录收集的字段：定长的整数或浮点数
+    /// </summary>
+    template<typename Node>
+    constexpr static bool gatherable = []() consteval {
+        using V = typename Node::type;
+        if constexpr (!Node::primitive || Node::dynamic)
+            return false;
+        else if constexpr ((::std::integral<V> && !::std::same_as<V, bool>) || ::std::floating_point<V>)
+            return sizeof(V) == 1 || sizeof(V) == 2 || sizeof(V) == 4 || sizeof(V) == 8;
+        else
+            return false;
+    }();
+
+    /// <summary>
+    /// out 的元素是 Base 指向的节点的值：Base 为根时就是记录本身，否则包装为 subtree_reference
+    /// </summary>
+    template<typename Base>
+    inline static decltype(auto) reference_of(auto& value) noexcept
+    {
+        if constexpr (Base::size == 0)
+            return (value);
+        else
+            return na::serializer::subtree_reference<Base, ::std::remove_reference_t<decltype(value)>>{value};
     }
-    inline constexpr static void serialize_postpend(auto& value, ::std::byte const* start, serialize_context& context)
+
+    /// <summary>
+    /// 按字段解码 count 条已校验的记录：可收集的字段一次从多条记录中 gather 并统一翻转字节序，其余字段逐条记录解码
+    /// </summary>
+    template<typename Node, typename Base, any_option Option, typename V>
+    inline static bool decode(V* out, ::std::byte const* input, ::std::size_t stride, ::std::size_t count, nbt_error& error_code) noexcept
     {
+        if constexpr (Node::composite)
+        {
+            return [&]<::std::size_t... Is>(::std::index_sequence<Is...>) {
+                return (decode<typename Node::template at<na::serializer::node_index<Is>>, Base, Option>(out, input, stride, count, error_code) && ... && true);
+            }(::std::make_index_sequence<Node::size>{});
+        }
+        else if constexpr (gatherable<Node>)
+        {
+            using F = typename Node::type;
+            constexpr auto swap{Option::endian != ::std::endian::native};
+            auto const payload{input + na::serializer::payload_minimal_offset<Node>};
+            if (gather_column_vectorized<sizeof(F), swap>(count))
+            {
+                // 字段地址只用来求偏移，各条记录都从数组本身的存储寻址，不越过 out[0] 的成员子对象
+                auto&& first{reference_of<Base>(out[0])};
+                auto& field{Node::payload_reference(first)};
+                auto const storage{reinterpret_cast<::std::byte*>(out)};
+                auto const field_offset{static_cast<::std::size_t>(reinterpret_cast<::std::byte*>(::std::addressof(field)) - storage)};
+                gather_column<sizeof(F), swap>(storage + field_offset, sizeof(V), payload, stride, count);
+            }
+            else
+            {
+                // 列太短或不需要翻转时逐条记录写入字段本身
+                for (::std::size_t i{0}; i < count; i++)
+                {
+                    auto&& reference{reference_of<Base>(out[i])};
+                    Node::payload_reference(reference) = endian_get<F, Option::endian>(payload + i * stride);
+                }
+            }
+            return true;
+        }
+        else
+        {
+            na::serializer::no_context allocation{};
+            for (::std::size_t i{0}; i < count; i++)
+            {
+                auto&& reference{reference_of<Base>(out[i])};
+                ::std::size_t offset{0};
+                if (!Node::deserialize_all(reference, input + i * stride, offset, 0, allocation, error_code)) [[unlikely]]
+                    return false;
+            }
+            return true;
+        }
     }
-    inline constexpr static void serialize_all(auto& value, ::std::byte const* start)
+
+    /// <summary>
+    /// 校验并解码尽可能多的记录。某条记录的常量字节不匹配时只解码它之前的记录
+    /// </summary>
+    template<typename Node, typename Base, any_option Option, typename T, typename V>
+    inline static bool run(::std::span<V> out, ::std::span<::std::byte const> input, ::std::size_t& consumed, nbt_error& error_code) noexcept
     {
+        using Root = batch_root<Option, T>;
+        static_assert(na::serializer::serialized_fixed_size<Root>, "batch decoding requires a fixed-size schema");
+        static_assert(na::serializer::skeleton<Root>::segment_count == 1);
+        constexpr ::std::size_t stride{na::serializer::total_minimal_size<Root>};
+        auto const count{::std::min(out.size(), input.size() / stride)};
+        auto valid{count};
+        for (::std::size_t i{0}; i < count; i++)
+        {
+            if (!na::serializer::skeleton<Root>::template matches<0>(input.data() + i * stride, 0)) [[unlikely]]
+            {
+                valid = i;
+                break;
+            }
+        }
+        consumed = 0;
+        if (valid != 0 && !decode<Node, Base, Option>(out.data(), input.data(), stride, valid, error_code)) [[unlikely]]
+            return false;
+        consumed = valid * stride;
+        if (valid != count) [[unlikely]]
+        {
+            error_code = nbt_error::invalid;
+            return false;
+        }
+        if (count != out.size()) [[unlikely]]
+        {
+            error_code = nbt_error::end_of_file;
+            return false;
+        }
+        return true;
     }
-};
\ No newline at end of file
+};
+}  // namespace detail
+
+/// <summary>
+/// 定长 schema 的一条记录序列化后的字节数，也是 deserialize_batch 的输入步长
+/// </summary>
+template<typename T, any_option Option = option<>>
+inline constexpr ::std::size_t record_size = na::serializer::total_minimal_size<detail::batch_root<Option, T>>;
+
+/// <summary>
+/// 从首尾相接的同构定长记录中解码 out.size() 条到结构体数组。先用骨架逐条校验 tag id 与名称，
+/// 再按字段而不是按记录解码：同一个数值字段一次从 8/16 条记录中 gather 到向量寄存器，统一翻转字节序后写回各记录。
+/// consumed 为成功解码的记录占用的字节数；输入不足时解码能容纳的记录并返回 end_of_file，遇到无效记录时解码它之前的记录并返回 invalid
+/// </summary>
+template<any_option Option = option<>, typename T>
+inline bool deserialize_batch(::std::span<T> out, ::std::span<::std::byte const> input, ::std::size_t& consumed, nbt_error& error_code) noexcept
+{
+    using Root = detail::batch_root<Option, T>;
+    return detail::batch_helper::run<Root, na::serializer::node_path<T>, Option, T>(out, input, consumed, error_code);
+}
+
+/// <summary>
+/// 与 deserialize_batch 相同，但只解码根的直接成员 Member，结果写成连续数组（结构体的数组转为数组的结构体），
+/// 例如 deserialize_column<&T::x>(xs, input, consumed, error_code)。数值成员的结果整条向量写出
+/// </summary>
+template<auto Member, any_option Option = option<>, typename V, typename T = typename detail::member_owner<decltype(Member)>::type>
+inline bool deserialize_column(::std::span<V> out, ::std::span<::std::byte const> input, ::std::size_t& consumed, nbt_error& error_code) noexcept
+{
+    using Root = detail::batch_root<Option, T>;
+    using Field = typename Root::template at<na::serializer::node_index<Root::template member_index<Member>>>;
+    static_assert(::std::same_as<V, typename Field::type>);
+    return detail::batch_helper::run<Field, typename Field::path, Option, T>(out, input, consumed, error_code);
+}
+}  // namespace na::nbt
\ No newline at end of file
@@ -0,0 +1,348 @@
+#pragma once
+#include "na_serializer.hpp"
+#include "na_serializer_nbt.hpp"
+#include "na_serializer_nbt_region.hpp"
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <thread>
+#include <utility>
+
+namespace na::nbt::region {
+/// <summary>
+/// 有界单生产者单消费者环形队列。两端的下标各占一条缓存行，并各自缓存对端下标，只有看起来满或空时才读取对端。
+/// 阻塞的 push/pop 在满或空时用 atomic wait 休眠而不是自旋；生产者 close 之后，消费者取完剩余元素时 pop 返回 false
+/// </summary>
+template<typename T, ::std::size_t Capacity>
+requires(::std::has_single_bit(Capacity))
+struct spsc_ring
+{
+    constexpr static ::std::size_t capacity = Capacity;
+
+    inline spsc_ring() noexcept = default;
+
+    spsc_ring(spsc_ring const&) = delete;
+    spsc_ring& operator=(spsc_ring const&) = delete;
+
+    /// <summary>
+    /// 只能由生产者调用
+    /// </summary>
+    inline bool try_push(T&& value) noexcept
+    {
+        auto const tail{tail_.load(::std::memory_order_relaxed) & index_mask};
+        if (tail - cached_head_ == Capacity)
+        {
+            cached_head_ = head_.load(::std::memory_order_acquire);
+            if (tail - cached_head_ == Capacity)
+                return false;
+        }
+        slots_[tail & (Capacity - 1)] = ::std::move(value);
+        tail_.store(tail + 1, ::std::memory_order_release);
+        tail_.notify_one();
+        return true;
+    }
+
+    /// <summary>
+    /// 队列满时休眠，直到消费者取走元素（背压）
+    /// </summary>
+    inline void push(T&& value) noexcept
+    {
+        while (!try_push(::std::move(value)))
+            head_.wait(cached_head_, ::std::memory_order_acquire);
+    }
+
+    /// <summary>
+    /// 只能由消费者调用
+    /// </summary>
+    inline bool try_pop(T& value) noexcept
+    {
+        if (head_local_ == cached_tail_)
+        {
+            cached_tail_ = tail_.load(::std::memory_order_acquire) & index_mask;
+            if (head_local_ == cached_tail_)
+                return false;
+        }
+        value = ::std::move(slots_[head_local_ & (Capacity - 1)]);
+        head_.store(++head_local_, ::std::memory_order_release);
+        head_.notify_one();
+        return true;
+    }
+
+    /// <summary>
+    /// 队列空时休眠；已关闭且为空时返回 false
+    /// </summary>
+    inline bool pop(T& value) noexcept
+    {
+        while (!try_pop(value))
+        {
+            auto const tail{tail_.load(::std::memory_order_acquire)};
+            if ((tail & index_mask) != head_local_)
+                continue;
+            if ((tail & closed_bit) != 0)
+                return false;
+            tail_.wait(tail, ::std::memory_order_acquire);
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// 由生产者调用，之后不能再 push
+    /// </summary>
+    inline void close() noexcept
+    {
+        tail_.fetch_or(closed_bit, ::std::memory_order_release);
+        tail_.notify_all();
+    }
+
+private:
+    // 关闭标志放在 tail 的最高位，使等待中的消费者在 close 时也能被唤醒
+    constexpr static ::std::size_t closed_bit = ~(~::std::size_t{0} >> 1);
+    constexpr static ::std::size_t index_mask = ~closed_bit;
+
+    // 不使用 hardware_destructive_interference_size，它随编译选项变化，会改变结构布局
+    constexpr static ::std::size_t line = 64;
+
+    alignas(line)::std::atomic<::std::size_t> head_{0};
+    ::std::size_t cached_tail_{0};
+    ::std::size_t head_local_{0};
+    alignas(line)::std::atomic<::std::size_t> tail_{0};
+    ::std::size_t cached_head_{0};
+    alignas(line) T slots_[Capacity]{};
+};
+
+/// <summary>
+/// 一次 chunk 加载请求；file 在结果回调之前必须保持打开，tag 原样交给回调
+/// </summary>
+struct chunk_request
+{
+    reader const* file{nullptr};
+    ::std::size_t index{0};
+    ::std::uint64_t tag{0};
+};
+
+/// <summary>
+/// 读取、解压、反序列化三个阶段各占一个线程，用有界 SPSC 队列串联，使不同 chunk 的 I/O、解压与反序列化重叠。
+/// 读取阶段校验位置表并触碰 chunk 所在的页，使缺页发生在这个线程；解压阶段从回收队列取出空闲缓冲区解压；
+/// 反序列化阶段调用 on_chunk(chunk_request const&, T&, nbt_error) 后把缓冲区归还给解压阶段。
+/// 缓冲区共 Depth 个，任何一级跟不上时上游在队列满或没有空闲缓冲区时休眠，最终由 submit 把背压传给调用方。
+/// 已经用其他方式（例如 io_uring）读入内存的扇区用 submit_sectors 提交，跳过映射；扇区复制到另外 Depth 个循环使用的缓冲区中，
+/// 反序列化之后同样归还。submit 与 submit_sectors 只能由同一个线程调用
+/// </summary>
+template<typename T, any_option Option = option<>, typename Decompressor = default_decompressor, ::std::size_t Depth = 64>
+struct pipeline
+{
+    using callback_type = ::std::function<void(chunk_request const&, T&, nbt_error)>;
+
+    inline explicit pipeline(callback_type on_chunk, ::std::size_t arena_size = 64 * 1024)
+      : on_chunk_{::std::move(on_chunk)}, arena_size_{arena_size == 0 ? 1 : arena_size}
+    {
+        // 所有缓冲区一开始都在回收队列中，线程启动之后回收队列只由反序列化阶段写入
+        for (::std::size_t i{0}; i < Depth; i++)
+        {
+            recycled_.try_push(decompress_buffer{});
+            recycled_sectors_.try_push(decompress_buffer{});
+        }
+        read_thread_ = ::std::thread{[this] { read_stage(); }};
+        inflate_thread_ = ::std::thread{[this] { inflate_stage(); }};
+        decode_thread_ = ::std::thread{[this] { decode_stage(); }};
+    }
+
+    pipeline(pipeline const&) = delete;
+    pipeline& operator=(pipeline const&) = delete;
+
+    inline ~pipeline()
+    {
+        close();
+    }
+
+    /// <summary>
+    /// 提交请求；队列满时阻塞
+    /// </summary>
+    inline void submit(chunk_request request) noexcept
+    {
+        requests_.push(submission{request});
+    }
+
+    /// <summary>
+    /// 提交请求；队列满时立即返回 false
+    /// </summary>
+    inline bool try_submit(chunk_request request) noexcept
+    {
+        return requests_.try_push(submission{request});
+    }
+
+    /// <summary>
+    /// 提交已经读入内存的 chunk 扇区（以 5 字节 chunk 头部开始），读取阶段只用 chunk_from_sectors 校验头部。
+    /// 数据被复制到空闲的扇区缓冲区，返回后 sectors 可以复用；没有空闲缓冲区时阻塞。
+    /// error_code 不为 ok 时不解码，直接交给回调。request.file 可以为空
+    /// </summary>
+    inline void submit_sectors(chunk_request request, ::std::span<::std::byte const> sectors, nbt_error error_code) noexcept
+    {
+        submission item{request, {}, false, 0, error_code, true};
+        if (error_code == nbt_error::ok)
+        {
+            recycled_sectors_.pop(item.sectors);
+            item.owns_sectors = true;
+            if (item.sectors.reserve(sectors.size() == 0 ? 1 : sectors.size(), 0))
+            {
+                ::std::memcpy(item.sectors.data.get(), sectors.data(), sectors.size());
+                item.length = sectors.size();
+            }
+            else
+            {
+                item.error_code = nbt_error::invalid;
+            }
+        }
+        requests_.push(::std::move(item));
+    }
+
+    /// <summary>
+    /// 停止接受请求，等待已提交的请求全部回调完毕
+    /// </summary>
+    inline void close() noexcept
+    {
+        if (!read_thread_.joinable())
+            return;
+        requests_.close();
+        read_thread_.join();
+        inflate_thread_.join();
+        decode_thread_.join();
+    }
+
+private:
+    struct submission
+    {
+        chunk_request request{};
+        // submit_sectors 提交的扇区副本，随 chunk 传到反序列化阶段之后归还 recycled_sectors_
+        decompress_buffer sectors{};
+        bool owns_sectors{false};
+        ::std::size_t length{0};
+        nbt_error error_code{};
+        bool loaded{false};
+    };
+
+    struct read_item
+    {
+        chunk_request request{};
+        chunk_span chunk{};
+        nbt_error error_code{};
+        decompress_buffer sectors{};
+        bool owns_sectors{false};
+    };
+
+    struct inflated_item
+    {
+        chunk_request request{};
+        ::std::span<::std::byte const> data{};
+        decompress_buffer buffer{};
+        bool owns_buffer{false};
+        nbt_error error_code{};
+        decompress_buffer sectors{};
+        bool owns_sectors{false};
+    };
+
+    inline void read_stage() noexcept
+    {
+        submission next{};
+        while (requests_.pop(next))
+        {
+            auto const& request{next.request};
+            read_item item{request, {}, nbt_error::ok, {}, next.owns_sectors};
+            if (next.loaded)
+            {
+                item.error_code = next.error_code;
+                if (item.error_code == nbt_error::ok)
+                    chunk_from_sectors({next.sectors.data.get(), next.length}, 0, item.chunk, item.error_code);
+                item.sectors = ::std::move(next.sectors);
+            }
+            else if (request.file == nullptr || request.index >= chunk_count)
+            {
+                item.error_code = nbt_error::invalid;
+            }
+            else if (!request.file->chunk(request.index, item.chunk, item.error_code))
+            {
+                // 不存在的 chunk 也交给回调，由 error_code 区分
+                if (item.error_code == nbt_error::ok)
+                    item.error_code = nbt_error::end_of_file;
+            }
+            else
+            {
+                // 每页读一个字节，把缺页留在读取线程
+                ::std::byte sink{};
+                for (::std::size_t i{0}; i < item.chunk.data.size(); i += sector_size)
+                    sink ^= static_cast<::std::byte volatile const&>(item.chunk.data[i]);
+                static_cast<void>(sink);
+            }
+            read_.push(::std::move(item));
+        }
+        read_.close();
+    }
+
+    inline void inflate_stage() noexcept
+    {
+        Decompressor decompressor{};
+        read_item item{};
+        while (read_.pop(item))
+        {
+            inflated_item out{item.request, item.chunk.data, {}, false, item.error_code, ::std::move(item.sectors), item.owns_sectors};
+            if (item.error_code == nbt_error::ok && item.chunk.type != compression::none)
+            {
+                recycled_.pop(out.buffer);
+                out.owns_buffer = true;
+                ::std::span<::std::byte> raw{};
+                if (decompressor.decompress(item.chunk.data, item.chunk.type, out.buffer, raw, out.error_code))
+                    out.data = raw;
+                else if (out.error_code == nbt_error::ok)
+                    out.error_code = nbt_error::invalid;
+            }
+            inflated_.push(::std::move(out));
+        }
+        inflated_.close();
+    }
+
+    inline void decode_stage()
+    {
+        ::std::unique_ptr<::std::byte[]> storage{new ::std::byte[arena_size_]};
+        ::std::pmr::monotonic_buffer_resource arena{storage.get(), arena_size_};
+        inflated_item item{};
+        while (inflated_.pop(item))
+        {
+            {
+                T value{};
+                if (item.error_code == nbt_error::ok)
+                {
+                    na::serializer::allocation_context allocation{&arena};
+                    ::std::size_t length{0};
+                    if (!na::serializer::deserialize<nbt, Option>(value, item.data, length, allocation, item.error_code) && item.error_code == nbt_error::ok)
+                        item.error_code = nbt_error::invalid;
+                }
+                on_chunk_(item.request, value, item.error_code);
+            }
+            arena.release();
+            // 回收队列容量等于缓冲区总数，归还不会阻塞
+            if (item.owns_buffer)
+                recycled_.push(::std::move(item.buffer));
+            if (item.owns_sectors)
+                recycled_sectors_.push(::std::move(item.sectors));
+        }
+    }
+
+    callback_type on_chunk_;
+    ::std::size_t arena_size_;
+    spsc_ring<submission, Depth> requests_{};
+    spsc_ring<read_item, Depth> read_{};
+    spsc_ring<inflated_item, Depth> inflated_{};
+    spsc_ring<decompress_buffer, Depth> recycled_{};
+    spsc_ring<decompress_buffer, Depth> recycled_sectors_{};
+    ::std::thread read_thread_{};
+    ::std::thread inflate_thread_{};
+    ::std::thread decode_thread_{};
+};
+}  // namespace na::nbt::region
\ No newline at end of file
@@ -0,0 +1,764 @@
+#pragma once
+#include "na_serializer.hpp"
+#include "na_serializer_nbt.hpp"
+#ifdef NA_SERIALIZER_HAS_ZLIB
+#include "na_serializer_nbt_zlib.hpp"
+#endif
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#error "region files are mapped with POSIX mmap"
+#endif
+
+namespace na::nbt::region {
+/// <summary>
+/// Anvil region 文件以 4 KiB 扇区为单位：扇区 0 是 1024 项位置表，扇区 1 是时间戳表，之后是 chunk 数据
+/// </summary>
+inline constexpr ::std::size_t sector_size = 4096;
+
+inline constexpr ::std::size_t chunks_per_side = 32;
+
+inline constexpr ::std::size_t chunk_count = chunks_per_side * chunks_per_side;
+
+inline constexpr ::std::size_t header_size = 2 * sector_size;
+
+/// <summary>
+/// chunk 数据的头部：4 字节大端长度（包含压缩类型字节）与 1 字节压缩类型
+/// </summary>
+inline constexpr ::std::size_t chunk_header_size = 5;
+
+/// <summary>
+/// 压缩类型的最高位表示数据存放在外部的 .mcc 文件中
+/// </summary>
+inline constexpr ::std::uint8_t external_flag = 0x80;
+
+/// <summary>
+/// 位置表中起始扇区只有 3 字节，扇区数只有 1 字节
+/// </summary>
+inline constexpr ::std::size_t max_sector_offset = 0xFFFFFF;
+
+inline constexpr ::std::size_t max_sector_count = 0xFF;
+
+/// <summary>
+/// 容纳 length 字节 chunk 数据（加上 5 字节头部）所需的扇区数
+/// </summary>
+inline constexpr ::std::size_t sectors_for(::std::size_t length) noexcept
+{
+    return (length + chunk_header_size + sector_size - 1) / sector_size;
+}
+
+/// <summary>
+/// 区域内坐标（取低 5 位）在两张表中的下标
+/// </summary>
+inline constexpr ::std::size_t chunk_index(::std::int32_t x, ::std::int32_t z) noexcept
+{
+    return (static_cast<::std::uint32_t>(x) & 31) + (static_cast<::std::uint32_t>(z) & 31) * chunks_per_side;
+}
+
+/// <summary>
+/// 位置表的一项：起始扇区（3 字节）与扇区数（1 字节），两者都为 0 表示 chunk 不存在
+/// </summary>
+struct chunk_location
+{
+    ::std::uint32_t sector_offset;
+    ::std::uint8_t sector_count;
+
+    inline constexpr bool empty() const noexcept
+    {
+        return sector_offset == 0 && sector_count == 0;
+    }
+};
+
+inline constexpr chunk_location decode_location(::std::uint32_t entry) noexcept
+{
+    return chunk_location{entry >> 8, static_cast<::std::uint8_t>(entry & 0xFF)};
+}
+
+inline constexpr ::std::uint32_t encode_location(chunk_location location) noexcept
+{
+    return (location.sector_offset << 8) | location.sector_count;
+}
+
+/// <summary>
+/// 映射中的一个 chunk：data 是压缩后的 payload（不含 5 字节头部），直接指向映射的内存
+/// </summary>
+struct chunk_span
+{
+    ::std::span<::std::byte const> data;
+    compression type;
+    ::std::uint32_t timestamp;
+};
+
+/// <summary>
+/// 从 chunk 占用的扇区中取出数据：sectors 以 5 字节 chunk 头部开始，校验长度与压缩类型，外部 .mcc 视为无效。
+/// 用于 reader 的映射，也用于其他方式（例如 io_uring）读入内存的扇区
+/// </summary>
+inline bool chunk_from_sectors(::std::span<::std::byte const> sectors, ::std::uint32_t timestamp, chunk_span& out, nbt_error& error_code) noexcept
+{
+    if (sectors.size() < chunk_header_size) [[unlikely]]
+    {
+        error_code = nbt_error::invalid;
+        return false;
+    }
+    auto const length{endian_get<::std::uint32_t, ::std::endian::big>(sectors.data())};
+    auto const type{static_cast<::std::uint8_t>(sectors[4])};
+    if (length == 0 || length > sectors.size() - 4 || (type & external_flag) != 0 || type < static_cast<::std::uint8_t>(compression::gzip) || type > static_cast<::std::uint8_t>(compression::none)) [[unlikely]]
+    {
+        error_code = nbt_error::invalid;
+        return false;
+    }
+    out = chunk_span{sectors.subspan(chunk_header_size, length - 1), static_cast<compression>(type), timestamp};
+    return true;
+}
+
+/// <summary>
+/// 以只读方式映射整个 .mca 文件，chunk 的读取不经过 read() 与中间缓冲区。
+/// 返回的 span 在 reader 关闭或销毁前有效
+/// </summary>
+struct reader
+{
+    inline reader() noexcept = default;
+
+    reader(reader const&) = delete;
+    reader& operator=(reader const&) = delete;
+
+    inline reader(reader&& other) noexcept : map_{other.map_}, size_{other.size_}
+    {
+        other.map_ = nullptr;
+        other.size_ = 0;
+    }
+
+    inline reader& operator=(reader&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            map_ = other.map_;
+            size_ = other.size_;
+            other.map_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    inline ~reader() noexcept
+    {
+        close();
+    }
+
+    /// <summary>
+    /// 映射 path 指向的文件；不足两个扇区的文件没有完整的表头，视为无效
+    /// </summary>
+    inline bool open(char const* path, nbt_error& error_code) noexcept
+    {
+        close();
+        auto const fd{::open(path, O_RDONLY | O_CLOEXEC)};
+        if (fd < 0)
+        {
+            error_code = nbt_error::invalid;
+            return false;
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || static_cast<::std::size_t>(st.st_size) < header_size)
+        {
+            ::close(fd);
+            error_code = st.st_size >= 0 && static_cast<::std::size_t>(st.st_size) < header_size ? nbt_error::end_of_file : nbt_error::invalid;
+            return false;
+        }
+        auto const size{static_cast<::std::size_t>(st.st_size)};
+        auto const map{::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0)};
+        // 映射建立后文件描述符不再需要
+        ::close(fd);
+        if (map == MAP_FAILED)
+        {
+            error_code = nbt_error::invalid;
+            return false;
+        }
+        map_ = static_cast<::std::byte const*>(map);
+        size_ = size;
+        return true;
+    }
+
+    inline void close() noexcept
+    {
+        if (map_ != nullptr)
+        {
+            ::munmap(const_cast<::std::byte*>(map_), size_);
+            map_ = nullptr;
+            size_ = 0;
+        }
+    }
+
+    inline bool is_open() const noexcept
+    {
+        return map_ != nullptr;
+    }
+
+    inline ::std::span<::std::byte const> bytes() const noexcept
+    {
+        return {map_, size_};
+    }
+
+    inline chunk_location location(::std::size_t index) const noexcept
+    {
+        return decode_location(endian_get<::std::uint32_t, ::std::endian::big>(map_ + index * 4));
+    }
+
+    inline ::std::uint32_t timestamp(::std::size_t index) const noexcept
+    {
+        return endian_get<::std::uint32_t, ::std::endian::big>(map_ + sector_size + index * 4);
+    }
+
+    inline bool contains(::std::int32_t x, ::std::int32_t z) const noexcept
+    {
+        return !location(chunk_index(x, z)).empty();
+    }
+
+    /// <summary>
+    /// 取出下标为 index 的 chunk。不存在时返回 false 且 error_code 为 ok；
+    /// 位置或长度越界、数据在外部 .mcc 文件或压缩类型未知时为 invalid
+    /// </summary>
+    inline bool chunk(::std::size_t index, chunk_span& out, nbt_error& error_code) const noexcept
+    {
+        auto const where{location(index)};
+        if (where.empty())
+        {
+            error_code = nbt_error::ok;
+            return false;
+        }
+        auto const begin{static_cast<::std::size_t>(where.sector_offset) * sector_size};
+        auto const limit{static_cast<::std::size_t>(where.sector_count) * sector_size};
+        if (where.sector_offset < 2 || begin > size_ || limit > size_ - begin) [[unlikely]]
+        {
+            error_code = nbt_error::invalid;
+            return false;
+        }
+        return chunk_from_sectors({map_ + begin, limit}, timestamp(index), out, error_code);
+    }
+
+    inline bool chunk(::std::int32_t x, ::std::int32_t z, chunk_span& out, nbt_error& error_code) const noexcept
+    {
+        return chunk(chunk_index(x, z), out, error_code);
+    }
+
+    /// <summary>
+    /// 提示内核预读某个 chunk 所在的扇区
+    /// </summary>
+    inline void prefetch(::std::size_t index) const noexcept
+    {
+        auto const where{location(index)};
+        auto const begin{static_cast<::std::size_t>(where.sector_offset) * sector_size};
+        auto const limit{static_cast<::std::size_t>(where.sector_count) * sector_size};
+        if (!where.empty() && begin <= size_ && limit <= size_ - begin)
+            ::madvise(const_cast<::std::byte*>(map_ + begin), limit, MADV_WILLNEED);
+    }
+
+private:
+    ::std::byte const* map_{nullptr};
+    ::std::size_t size_{0};
+};
+
+/// <summary>
+/// 以读写方式打开 .mca 文件并维护扇区占用表。
+/// write 直接把 chunk 数据写到文件中：新数据仍放得下原来的扇区时原地覆盖并释放多余的尾部扇区，
+/// 否则从第一个足够大的空闲区间分配，没有时追加到文件末尾。位置表与时间戳表只在内存中修改，
+/// 并记录各自被改动的字节范围，flush 时只写回这两段范围，因此一批 write 只需要一次表头写入。
+/// 被释放的扇区在 flush 之后才会被再次分配，保证落盘的表头不会指向已被其他 chunk 覆盖的数据
+/// </summary>
+struct writer
+{
+    inline writer() noexcept = default;
+
+    writer(writer const&) = delete;
+    writer& operator=(writer const&) = delete;
+
+    inline ~writer() noexcept
+    {
+        close();
+    }
+
+    /// <summary>
+    /// 打开或创建 path；空文件会被扩展为只有表头的空 region
+    /// </summary>
+    inline bool open(char const* path, nbt_error& error_code) noexcept
+    {
+        close();
+        fd_ = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+            return fail(error_code, nbt_error::invalid);
+        struct stat st{};
+        if (::fstat(fd_, &st) != 0)
+            return abandon(error_code, nbt_error::invalid);
+        auto const size{static_cast<::std::size_t>(st.st_size)};
+        if (size == 0)
+        {
+            if (::ftruncate(fd_, static_cast<off_t>(header_size)) != 0)
+                return abandon(error_code, nbt_error::invalid);
+            header_.fill(::std::byte{0});
+        }
+        else if (size < header_size || !read_all(header_.data(), header_size, 0))
+        {
+            return abandon(error_code, size < header_size ? nbt_error::end_of_file : nbt_error::invalid);
+        }
+        // 文件末尾不足一个扇区的部分也视为占用，追加的 chunk 从下一个完整扇区开始
+        auto const sector_total{(::std::max(size, header_size) + sector_size - 1) / sector_size};
+        // 每个扇区被多少个位置表项引用；表头扇区预先计入，指向表头的表项因此也算作重叠
+        ::std::vector<::std::uint8_t> claims{};
+        try
+        {
+            used_.assign(sector_total, false);
+            claims.assign(sector_total, 0);
+        }
+        catch (::std::bad_alloc const&)
+        {
+            used_.clear();
+            return abandon(error_code, nbt_error::invalid);
+        }
+        used_[0] = used_[1] = true;
+        claims[0] = claims[1] = 1;
+        for (::std::size_t index{0}; index < chunk_count; index++)
+        {
+            auto const where{location(index)};
+            if (where.empty())
+                continue;
+            for (auto sector{where.sector_offset}; sector < where.sector_offset + where.sector_count && sector < used_.size(); sector++)
+            {
+                used_[sector] = true;
+                if (claims[sector] != 0xFF)
+                    claims[sector]++;
+            }
+        }
+        // 只有完全位于文件内、不与表头或其他 chunk 重叠的表项才属于该 chunk 自己，可以原地覆盖与释放；
+        // 损坏表项引用的扇区仍然标记为占用，不会分配给其他 chunk
+        for (::std::size_t index{0}; index < chunk_count; index++)
+        {
+            auto const where{location(index)};
+            auto const end{static_cast<::std::size_t>(where.sector_offset) + where.sector_count};
+            owned_[index] = !where.empty() && end <= used_.size() && ::std::all_of(claims.begin() + where.sector_offset, claims.begin() + end, [](::std::uint8_t claim) { return claim == 1; });
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// 写回尚未落盘的表头并关闭文件
+    /// </summary>
+    inline bool close() noexcept
+    {
+        if (fd_ < 0)
+            return true;
+        nbt_error error_code{};
+        auto const flushed{flush(false, error_code)};
+        ::close(fd_);
+        fd_ = -1;
+        used_.clear();
+        released_.clear();
+        return flushed;
+    }
+
+    inline bool is_open() const noexcept
+    {
+        return fd_ >= 0;
+    }
+
+    inline chunk_location location(::std::size_t index) const noexcept
+    {
+        return decode_location(endian_get<::std::uint32_t, ::std::endian::big>(header_.data() + index * 4));
+    }
+
+    inline ::std::uint32_t timestamp(::std::size_t index) const noexcept
+    {
+        return endian_get<::std::uint32_t, ::std::endian::big>(header_.data() + sector_size + index * 4);
+    }
+
+    /// <summary>
+    /// 打开时位置表项已损坏：指向表头、超出文件末尾或与其他 chunk 重叠。写入这样的 chunk 总是分配新的扇区
+    /// </summary>
+    inline bool corrupt(::std::size_t index) const noexcept
+    {
+        return !location(index).empty() && !owned_[index];
+    }
+
+    /// <summary>
+    /// 文件当前的扇区数
+    /// </summary>
+    inline ::std::size_t sectors() const noexcept
+    {
+        return used_.size();
+    }
+
+    /// <summary>
+    /// 写入一个已经压缩好的 chunk。超过 255 个扇区的 chunk 需要外部 .mcc 文件，不支持
+    /// </summary>
+    inline bool write(::std::size_t index, ::std::span<::std::byte const> data, compression type, ::std::uint32_t timestamp, nbt_error& error_code) noexcept
+    {
+        ::iovec piece{const_cast<::std::byte*>(data.data()), data.size()};
+        return write(index, ::std::span<::iovec const>{&piece, 1}, data.size(), type, timestamp, error_code);
+    }
+
+    inline bool write(::std::int32_t x, ::std::int32_t z, ::std::span<::std::byte const> data, compression type, ::std::uint32_t timestamp, nbt_error& error_code) noexcept
+    {
+        return write(chunk_index(x, z), data, type, timestamp, error_code);
+    }
+
+    /// <summary>
+    /// 写入由多段组成的 chunk 数据（例如 memory_builder 的各个块），各段与头部、填充一起交给 pwritev，段数较多时分批写出；分配失败也以 invalid 返回
+    /// </summary>
+    inline bool write(::std::size_t index, ::std::span<::iovec const> pieces, ::std::size_t length, compression type, ::std::uint32_t timestamp, nbt_error& error_code) noexcept
+    {
+        if (fd_ < 0 || index >= chunk_count || type < compression::gzip || type > compression::none) [[unlikely]]
+            return fail(error_code, nbt_error::invalid);
+        auto const count{sectors_for(length)};
+        if (count > max_sector_count || length + 1 > 0xFFFFFFFFu) [[unlikely]]
+            return fail(error_code, nbt_error::invalid);
+        auto const old{location(index)};
+        // 不属于这个 chunk 的旧范围既不原地覆盖也不释放
+        auto const owned{owned_[index]};
+        // 写出之前先为释放旧扇区留好位置，写出之后的步骤不再分配
+        if (owned && !reserve_release()) [[unlikely]]
+            return fail(error_code, nbt_error::invalid);
+        ::std::size_t start{old.sector_offset};
+        if (!owned || count > old.sector_count)
+        {
+            if (!allocate(count, start))
+                return fail(error_code, nbt_error::invalid);
+        }
+
+        ::std::byte head[chunk_header_size];
+        endian_set<::std::uint32_t, ::std::endian::big>(head, static_cast<::std::uint32_t>(length + 1));
+        head[4] = static_cast<::std::byte>(type);
+        static constexpr ::std::byte zeros[sector_size]{};
+        // 依次是头部、各段数据与补齐最后一个扇区的填充，保持文件长度是扇区的整数倍
+        auto const padding{count * sector_size - length - chunk_header_size};
+        auto const piece_at{[&](::std::size_t i) noexcept {
+            if (i == 0)
+                return ::iovec{head, chunk_header_size};
+            if (i <= pieces.size())
+                return pieces[i - 1];
+            return ::iovec{const_cast<::std::byte*>(zeros), padding};
+        }};
+        auto const in_place{owned && start == old.sector_offset};
+        if (!write_all(pieces.size() + (padding != 0 ? 2 : 1), piece_at, start * sector_size)) [[unlikely]]
+        {
+            if (!in_place)
+                mark(start, count, false);
+            return fail(error_code, nbt_error::invalid);
+        }
+
+        if (!in_place)
+        {
+            if (owned)
+                release(old.sector_offset, old.sector_count);
+        }
+        else if (count < old.sector_count)
+        {
+            release(start + count, old.sector_count - count);
+        }
+        set_entry(index, chunk_location{static_cast<::std::uint32_t>(start), static_cast<::std::uint8_t>(count)}, timestamp);
+        owned_[index] = true;
+        return true;
+    }
+
+    /// <summary>
+    /// 删除一个 chunk；它的扇区在下一次 flush 之后可以被复用
+    /// </summary>
+    inline bool erase(::std::size_t index, nbt_error& error_code) noexcept
+    {
+        if (fd_ < 0 || index >= chunk_count) [[unlikely]]
+            return fail(error_code, nbt_error::invalid);
+        auto const old{location(index)};
+        if (old.empty())
+            return true;
+        if (owned_[index])
+        {
+            if (!reserve_release()) [[unlikely]]
+                return fail(error_code, nbt_error::invalid);
+            release(old.sector_offset, old.sector_count);
+        }
+        set_entry(index, chunk_location{0, 0}, 0);
+        owned_[index] = false;
+        return true;
+    }
+
+    /// <summary>
+    /// 写回两张表中被改动的字节范围，并让被释放的扇区可以再次分配；sync 为 true 时等待数据落盘
+    /// </summary>
+    inline bool flush(bool sync, nbt_error& error_code) noexcept
+    {
+        if (fd_ < 0) [[unlikely]]
+            return fail(error_code, nbt_error::invalid);
+        for (auto& range : dirty_)
+        {
+            if (range.begin == range.end)
+                continue;
+            ::iovec const piece{header_.data() + range.begin, range.end - range.begin};
+            if (!write_all(1, [&piece](::std::size_t) noexcept { return piece; }, range.begin)) [[unlikely]]
+                return fail(error_code, nbt_error::invalid);
+            range = dirty_range{};
+        }
+        if (sync && ::fdatasync(fd_) != 0) [[unlikely]]
+            return fail(error_code, nbt_error::invalid);
+        for (auto const& [start, count] : released_)
+            mark(start, count, false);
+        released_.clear();
+        return true;
+    }
+
+    /// <summary>
+    /// 尚未写回的表头字节数
+    /// </summary>
+    inline ::std::size_t dirty_bytes() const noexcept
+    {
+        return (dirty_[0].end - dirty_[0].begin) + (dirty_[1].end - dirty_[1].begin);
+    }
+
+private:
+    struct dirty_range
+    {
+        ::std::size_t begin{0};
+        ::std::size_t end{0};
+    };
+
+    struct extent
+    {
+        ::std::size_t start;
+        ::std::size_t count;
+    };
+
+    inline static bool fail(nbt_error& error_code, nbt_error value) noexcept
+    {
+        error_code = value;
+        return false;
+    }
+
+    inline bool abandon(nbt_error& error_code, nbt_error value) noexcept
+    {
+        ::close(fd_);
+        fd_ = -1;
+        return fail(error_code, value);
+    }
+
+    inline bool read_all(::std::byte* target, ::std::size_t length, ::std::size_t position) const noexcept
+    {
+        while (length != 0)
+        {
+            auto const n{::pread(fd_, target, length, static_cast<off_t>(position))};
+            if (n <= 0)
+                return false;
+            target += n;
+            length -= static_cast<::std::size_t>(n);
+            position += static_cast<::std::size_t>(n);
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// 写出 count 段数据，piece(i) 返回第 i 段。每次最多取 iovec_batch 段放进栈上的数组交给 pwritev，不做堆分配
+    /// </summary>
+    inline bool write_all(::std::size_t count, auto const& piece, ::std::size_t position) const noexcept
+    {
+        ::iovec batch[iovec_batch];
+        ::std::size_t first{0};
+        // 第 first 段中已经写出的字节数
+        ::std::size_t skipped{0};
+        while (first < count)
+        {
+            ::std::size_t used{0};
+            for (; used < iovec_batch && first + used < count; used++)
+                batch[used] = piece(first + used);
+            batch[0].iov_base = static_cast<::std::byte*>(batch[0].iov_base) + skipped;
+            batch[0].iov_len -= skipped;
+            auto n{::pwritev(fd_, batch, static_cast<int>(used), static_cast<off_t>(position))};
+            if (n < 0)
+                return false;
+            position += static_cast<::std::size_t>(n);
+            // 跳过已经完整写出的段，部分写出的段记下已写出的字节数后重试
+            for (::std::size_t i{0}; i < used && static_cast<::std::size_t>(n) >= batch[i].iov_len; i++)
+            {
+                n -= static_cast<::ssize_t>(batch[i].iov_len);
+                first++;
+                skipped = 0;
+            }
+            skipped += static_cast<::std::size_t>(n);
+        }
+        return true;
+    }
+
+    inline void mark(::std::size_t start, ::std::size_t count, bool value) noexcept
+    {
+        for (auto sector{start}; sector < start + count && sector < used_.size(); sector++)
+            used_[sector] = value;
+    }
+
+    /// <summary>
+    /// 保证 released_ 至少还能放下一项，之后的 release 不会分配
+    /// </summary>
+    inline bool reserve_release() noexcept
+    {
+        if (released_.size() < released_.capacity())
+            return true;
+        try
+        {
+            released_.reserve(::std::max<::std::size_t>(released_.size() * 2, 16));
+        }
+        catch (::std::bad_alloc const&)
+        {
+            return false;
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// 释放前需要 reserve_release 成功；同一次 write 最多释放一段
+    /// </summary>
+    inline void release(::std::size_t start, ::std::size_t count) noexcept
+    {
+        released_.push_back(extent{start, count});
+    }
+
+    /// <summary>
+    /// 首次适配：从第一个足够长的空闲区间分配；末尾的空闲区间可以向文件之外延伸
+    /// </summary>
+    inline bool allocate(::std::size_t count, ::std::size_t& start) noexcept
+    {
+        ::std::size_t run{0};
+        start = used_.size();
+        for (::std::size_t sector{2}; sector < used_.size(); sector++)
+        {
+            if (used_[sector])
+            {
+                run = 0;
+                continue;
+            }
+            if (run++ == 0)
+                start = sector;
+            if (run == count)
+                break;
+        }
+        if (run == 0)
+            start = used_.size();
+        if (start + count - 1 > max_sector_offset) [[unlikely]]
+            return false;
+        if (start + count > used_.size())
+        {
+            try
+            {
+                used_.resize(start + count, false);
+            }
+            catch (::std::bad_alloc const&)
+            {
+                return false;
+            }
+        }
+        mark(start, count, true);
+        return true;
+    }
+
+    inline void set_entry(::std::size_t index, chunk_location where, ::std::uint32_t timestamp) noexcept
+    {
+        endian_set<::std::uint32_t, ::std::endian::big>(header_.data() + index * 4, encode_location(where));
+        endian_set<::std::uint32_t, ::std::endian::big>(header_.data() + sector_size + index * 4, timestamp);
+        touch(dirty_[0], index * 4);
+        touch(dirty_[1], sector_size + index * 4);
+    }
+
+    inline static void touch(dirty_range& range, ::std::size_t position) noexcept
+    {
+        if (range.begin == range.end)
+        {
+            range = dirty_range{position, position + 4};
+            return;
+        }
+        range.begin = ::std::min(range.begin, position);
+        range.end = ::std::max(range.end, position + 4);
+    }
+
+    inline static constexpr ::std::size_t iovec_batch{::std::min<::std::size_t>(64, IOV_MAX)};
+
+    int fd_{-1};
+    alignas(8)::std::array<::std::byte, header_size> header_{};
+    dirty_range dirty_[2]{};
+    ::std::vector<bool> used_{};
+    ::std::array<bool, chunk_count> owned_{};
+    ::std::vector<extent> released_{};
+};
+
+/// <summary>
+/// 不压缩地序列化 value 并写入 (x, z)。scratch 在多次调用之间 clear 后复用，数据按块直接交给 pwritev
+/// </summary>
+template<any_option Option = option<>, ::std::size_t InlineCapacity, typename Allocator>
+inline bool write_chunk(writer& file, ::std::int32_t x, ::std::int32_t z, auto const& value, ::std::uint32_t timestamp, na::serializer::memory_builder<InlineCapacity, Allocator>& scratch, nbt_error& error_code)
+{
+    scratch.clear();
+    if (!na::serializer::serialize<nbt, Option>(value, scratch, error_code))
+        return false;
+    ::std::vector<::iovec> pieces{};
+    scratch.for_each_chunk([&pieces](::std::span<::std::byte const> piece) { pieces.push_back(::iovec{const_cast<::std::byte*>(piece.data()), piece.size()}); });
+    return file.write(chunk_index(x, z), pieces, scratch.size(), compression::none, timestamp, error_code);
+}
+
+/// <summary>
+/// 不带压缩库时使用：只接受未压缩的 chunk，其余压缩类型视为无效
+/// </summary>
+struct no_decompressor
+{
+    inline bool decompress(::std::span<::std::byte const>, compression, ::std::span<::std::byte>&, nbt_error& error_code) const noexcept
+    {
+        error_code = nbt_error::invalid;
+        return false;
+    }
+
+    inline bool decompress(::std::span<::std::byte const>, compression, decompress_buffer&, ::std::span<::std::byte>&, nbt_error& error_code) const noexcept
+    {
+        error_code = nbt_error::invalid;
+        return false;
+    }
+};
+
+/// <summary>
+/// 批量读取（scan、pipeline）默认使用的解压器
+/// </summary>
+#ifdef NA_SERIALIZER_HAS_ZLIB
+using default_decompressor = inflater;
+#else
+using default_decompressor = no_decompressor;
+#endif
+
+/// <summary>
+/// 读取一个 chunk 并反序列化。未压缩的 chunk 直接从映射反序列化，其余交给 decompressor
+/// （例如 na_serializer_nbt_zlib.hpp 中的 inflater）解压；字符串与 view 引用映射或 decompressor 的缓冲区。
+/// allocation 为 allocation_context 时，变长数据从其中的 resource 分配
+/// </summary>
+template<any_option Option = option<>>
+inline bool read_chunk(reader const& file, ::std::int32_t x, ::std::int32_t z, auto& value, auto&& decompressor, auto& allocation, nbt_error& error_code) noexcept
+{
+    chunk_span chunk{};
+    if (!file.chunk(x, z, chunk, error_code))
+        return false;
+    ::std::size_t length{0};
+    if (chunk.type == compression::none)
+        return na::serializer::deserialize<nbt, Option>(value, chunk.data, length, allocation, error_code);
+    ::std::span<::std::byte> raw{};
+    if (!decompressor.decompress(chunk.data, chunk.type, raw, error_code))
+        return false;
+    return na::serializer::deserialize<nbt, Option>(value, ::std::span<::std::byte const>{raw}, length, allocation, error_code);
+}
+
+template<any_option Option = option<>>
+inline bool read_chunk(reader const& file, ::std::int32_t x, ::std::int32_t z, auto& value, auto&& decompressor, nbt_error& error_code) noexcept
+{
+    na::serializer::no_context allocation{};
+    return read_chunk<Option>(file, x, z, value, decompressor, allocation, error_code);
+}
+}  // namespace na::nbt::region
\ No newline at end of file
@@ -0,0 +1,222 @@
+#pragma once
+#include "na_serializer.hpp"
+#include "na_serializer_nbt.hpp"
+#include "na_serializer_nbt_region.hpp"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace na::nbt::region {
+/// <summary>
+/// 扫描到的一个 chunk。x、z 是世界 chunk 坐标；文件名不是 r.X.Z.mca 形式时为区域内坐标
+/// </summary>
+struct scan_chunk
+{
+    ::std::filesystem::path const* file;
+    ::std::int32_t x;
+    ::std::int32_t z;
+    ::std::uint32_t timestamp;
+};
+
+struct scan_options
+{
+    /// <summary>
+    /// 工作线程数，0 表示 hardware_concurrency
+    /// </summary>
+    unsigned threads{0};
+    /// <summary>
+    /// 每个线程 arena 的初始缓冲区大小，解码结果的变长数据从中分配，每个 chunk 之后整体释放
+    /// </summary>
+    ::std::size_t arena_size{64 * 1024};
+};
+
+struct scan_stats
+{
+    ::std::size_t files{0};
+    ::std::size_t chunks{0};
+    ::std::size_t failed_files{0};
+    ::std::size_t failed_chunks{0};
+};
+
+/// <summary>
+/// 从 r.X.Z.mca 中解析区域坐标
+/// </summary>
+inline bool parse_region_name(::std::string_view name, ::std::int32_t& x, ::std::int32_t& z) noexcept
+{
+    if (!name.starts_with("r.") || !name.ends_with(".mca"))
+        return false;
+    name = name.substr(2, name.size() - 6);
+    auto const dot{name.find('.')};
+    if (dot == ::std::string_view::npos)
+        return false;
+    auto const rx{::std::from_chars(name.data(), name.data() + dot, x)};
+    auto const rz{::std::from_chars(name.data() + dot + 1, name.data() + name.size(), z)};
+    return rx.ec == ::std::errc{} && rx.ptr == name.data() + dot && rz.ec == ::std::errc{} && rz.ptr == name.data() + name.size();
+}
+
+namespace detail {
+/// <summary>
+/// 工作窃取队列：所有任务在开始前放入，拥有者从尾部取，其他线程从头部窃取。
+/// 任务是整个 region 文件，粒度足够粗，一把互斥锁的开销可以忽略
+/// </summary>
+struct steal_queue
+{
+    ::std::mutex mutex;
+    ::std::deque<::std::size_t> tasks;
+
+    inline bool pop(::std::size_t& task)
+    {
+        ::std::lock_guard lock{mutex};
+        if (tasks.empty())
+            return false;
+        task = tasks.back();
+        tasks.pop_back();
+        return true;
+    }
+
+    inline bool steal(::std::size_t& task)
+    {
+        ::std::lock_guard lock{mutex};
+        if (tasks.empty())
+            return false;
+        task = tasks.front();
+        tasks.pop_front();
+        return true;
+    }
+};
+}  // namespace detail
+
+/// <summary>
+/// 并行扫描 directory 下所有 .mca 文件，把每个 chunk 解码为 T 并交给 on_chunk(scan_chunk const&, T&, nbt_error)。
+/// 解码失败时 value 不完整且 error_code 不为 ok。on_chunk 在工作线程中并发调用，需要自行同步；返回 bool 时 false 停止扫描。
+/// 每个线程持有自己的 Decompressor、arena 与 T，文件按大小从大到小轮流分给各线程，空闲的线程从其他线程的队列头部窃取。
+/// value 中的字符串与 view 只在回调期间有效
+/// </summary>
+template<typename T, any_option Option = option<>, typename Decompressor = default_decompressor>
+inline scan_stats scan(::std::filesystem::path const& directory, auto&& on_chunk, scan_options const& options = {})
+{
+    ::std::vector<::std::filesystem::path> files{};
+    ::std::vector<::std::uintmax_t> sizes{};
+    ::std::error_code fs_error{};
+    for (auto const& entry : ::std::filesystem::directory_iterator{directory, fs_error})
+    {
+        if (entry.is_regular_file(fs_error) && entry.path().extension() == ".mca")
+            files.push_back(entry.path());
+    }
+    scan_stats total{};
+    total.files = files.size();
+    if (files.empty())
+        return total;
+
+    sizes.reserve(files.size());
+    for (auto const& file : files)
+    {
+        auto const size{::std::filesystem::file_size(file, fs_error)};
+        sizes.push_back(fs_error ? 0 : size);
+    }
+    ::std::vector<::std::size_t> order(files.size());
+    for (::std::size_t i{0}; i < order.size(); i++)
+        order[i] = i;
+    ::std::stable_sort(order.begin(), order.end(), [&sizes](auto a, auto b) { return sizes[a] > sizes[b]; });
+
+    auto workers{options.threads != 0 ? options.threads : ::std::thread::hardware_concurrency()};
+    if (workers == 0)
+        workers = 1;
+    if (workers > files.size())
+        workers = static_cast<unsigned>(files.size());
+    ::std::unique_ptr<detail::steal_queue[]> queues{new detail::steal_queue[workers]};
+    // 最大的文件排在各队列尾部，拥有者先处理它们，较小的文件留在头部供窃取
+    for (::std::size_t i{order.size()}; i-- != 0;)
+        queues[i % workers].tasks.push_back(order[i]);
+
+    ::std::atomic<bool> stop{false};
+    ::std::vector<scan_stats> stats(workers);
+    auto const work{[&](unsigned self) {
+        Decompressor decompressor{};
+        ::std::unique_ptr<::std::byte[]> buffer{new ::std::byte[options.arena_size == 0 ? 1 : options.arena_size]};
+        ::std::pmr::monotonic_buffer_resource arena{buffer.get(), options.arena_size == 0 ? 1 : options.arena_size};
+        reader file{};
+        auto& local{stats[self]};
+        ::std::size_t task{0};
+        while (!stop.load(::std::memory_order_relaxed))
+        {
+            auto found{queues[self].pop(task)};
+            for (unsigned i{1}; !found && i < workers; i++)
+                found = queues[(self + i) % workers].steal(task);
+            if (!found)
+                break;
+
+            nbt_error error_code{};
+            if (!file.open(files[task].c_str(), error_code))
+            {
+                local.failed_files++;
+                continue;
+            }
+            ::std::int32_t rx{0};
+            ::std::int32_t rz{0};
+            parse_region_name(files[task].filename().native(), rx, rz);
+            for (::std::size_t index{0}; index < chunk_count && !stop.load(::std::memory_order_relaxed); index++)
+            {
+                if (file.location(index).empty())
+                    continue;
+                if (index + 1 < chunk_count)
+                    file.prefetch(index + 1);
+                auto const cx{static_cast<::std::int32_t>(index % chunks_per_side)};
+                auto const cz{static_cast<::std::int32_t>(index / chunks_per_side)};
+                scan_chunk const info{&files[task], rx * static_cast<::std::int32_t>(chunks_per_side) + cx, rz * static_cast<::std::int32_t>(chunks_per_side) + cz, file.timestamp(index)};
+                na::serializer::allocation_context allocation{&arena};
+                bool continued{true};
+                {
+                    T value{};
+                    error_code = nbt_error::ok;
+                    if (read_chunk<Option>(file, cx, cz, value, decompressor, allocation, error_code))
+                    {
+                        error_code = nbt_error::ok;
+                        local.chunks++;
+                    }
+                    else
+                    {
+                        if (error_code == nbt_error::ok)
+                            error_code = nbt_error::invalid;
+                        local.failed_chunks++;
+                    }
+                    if constexpr (::std::is_same_v<decltype(on_chunk(info, value, error_code)), bool>)
+                        continued = on_chunk(info, value, error_code);
+                    else
+                        on_chunk(info, value, error_code);
+                }
+                // value 已析构，arena 可以整体回收
+                arena.release();
+                if (!continued)
+                    stop.store(true, ::std::memory_order_relaxed);
+            }
+            file.close();
+        }
+    }};
+
+    ::std::vector<::std::thread> threads{};
+    threads.reserve(workers - 1);
+    for (unsigned i{1}; i < workers; i++)
+        threads.emplace_back(work, i);
+    work(0);
+    for (auto& thread : threads)
+        thread.join();
+    for (auto const& local : stats)
+    {
+        total.chunks += local.chunks;
+        total.failed_files += local.failed_files;
+        total.failed_chunks += local.failed_chunks;
+    }
+    return total;
+}
+}  // namespace na::nbt::region
\ No newline at end of file
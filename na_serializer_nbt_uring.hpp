@@ -0,0 +1,406 @@
+#pragma once
+#include "na_serializer.hpp"
+#include "na_serializer_nbt.hpp"
+#include "na_serializer_nbt_pipeline.hpp"
+#include "na_serializer_nbt_region.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include <vector>
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#error "na_serializer_nbt_uring.hpp requires Linux io_uring"
+#endif
+
+namespace na::nbt {
+/// <summary>
+/// 一次读取：从 fd 的 offset 处读取 length 字节，tag 原样交给回调
+/// </summary>
+struct read_request
+{
+    int fd{-1};
+    ::std::uint64_t offset{0};
+    ::std::uint32_t length{0};
+    ::std::uint64_t tag{0};
+};
+
+/// <summary>
+/// 直接通过系统调用使用 io_uring 的批量读取器，不依赖 liburing。
+/// depth 个大小为 buffer_size 的槽位在 open 时一次分配并注册为固定缓冲区（注册失败时退回普通读取），
+/// read_batch 让最多 depth 个读取同时在途，一次 io_uring_enter 同时提交新请求并等待完成，
+/// 完成的数据在回调期间有效，回调返回后槽位立即用于下一个请求。读取器不是线程安全的
+/// </summary>
+struct uring_reader
+{
+    inline uring_reader() noexcept = default;
+
+    uring_reader(uring_reader const&) = delete;
+    uring_reader& operator=(uring_reader const&) = delete;
+
+    inline ~uring_reader() noexcept
+    {
+        close();
+    }
+
+    /// <summary>
+    /// 创建 ring；内核不支持或被禁止时返回 false，调用方可以退回普通读取。
+    /// register_buffers 为 false 时不注册固定缓冲区，总是使用 IORING_OP_READ
+    /// </summary>
+    inline bool open(unsigned depth, ::std::size_t buffer_size, bool register_buffers, nbt_error& error_code) noexcept
+    {
+        close();
+        if (depth == 0 || buffer_size == 0 || buffer_size > 0xFFFFFFFFu)
+            return fail(error_code);
+        ::io_uring_params params{};
+        ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &params));
+        if (ring_fd_ < 0)
+            return fail(error_code);
+        params_ = params;
+        sq_size_ = params.sq_off.array + params.sq_entries * sizeof(::std::uint32_t);
+        cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(::io_uring_cqe);
+        // 新内核中两个 ring 共用一次映射
+        if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+            sq_size_ = cq_size_ = sq_size_ > cq_size_ ? sq_size_ : cq_size_;
+        sq_ring_ = ::mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED)
+            return abandon(error_code);
+        if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+        {
+            cq_ring_ = sq_ring_;
+        }
+        else
+        {
+            cq_ring_ = ::mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+            if (cq_ring_ == MAP_FAILED)
+                return abandon(error_code);
+        }
+        sqes_size_ = params.sq_entries * sizeof(::io_uring_sqe);
+        auto const sqes{::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES)};
+        if (sqes == MAP_FAILED)
+            return abandon(error_code);
+        sqes_ = static_cast<::io_uring_sqe*>(sqes);
+
+        depth_ = depth < params.sq_entries ? depth : params.sq_entries;
+        buffer_size_ = (buffer_size + 4095) & ~::std::size_t{4095};
+        buffers_ = static_cast<::std::byte*>(::std::aligned_alloc(4096, buffer_size_ * depth_));
+        if (buffers_ == nullptr)
+            return abandon(error_code);
+        ::std::vector<::iovec> vectors(depth_);
+        for (unsigned i{0}; i < depth_; i++)
+            vectors[i] = ::iovec{buffers_ + i * buffer_size_, buffer_size_};
+        // 固定缓冲区省去每次读取时的页表查找与引用计数；超过 RLIMIT_MEMLOCK 时注册失败，仍可用普通读取
+        fixed_ = register_buffers && ::syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, vectors.data(), depth_) == 0;
+        fixed_reads_ = plain_reads_ = 0;
+        slots_.assign(depth_, slot{});
+        free_.clear();
+        for (unsigned i{depth_}; i-- != 0;)
+            free_.push_back(i);
+        return true;
+    }
+
+    inline bool open(unsigned depth, ::std::size_t buffer_size, nbt_error& error_code) noexcept
+    {
+        return open(depth, buffer_size, true, error_code);
+    }
+
+    inline void close() noexcept
+    {
+        if (ring_fd_ < 0)
+            return;
+        if (sqes_ != nullptr)
+            ::munmap(sqes_, sqes_size_);
+        if (cq_ring_ != nullptr && cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_)
+            ::munmap(cq_ring_, cq_size_);
+        if (sq_ring_ != nullptr && sq_ring_ != MAP_FAILED)
+            ::munmap(sq_ring_, sq_size_);
+        // 关闭 ring 同时注销固定缓冲区
+        ::close(ring_fd_);
+        ::std::free(buffers_);
+        ring_fd_ = -1;
+        sq_ring_ = cq_ring_ = nullptr;
+        sqes_ = nullptr;
+        buffers_ = nullptr;
+        fixed_ = false;
+    }
+
+    inline bool is_open() const noexcept
+    {
+        return ring_fd_ >= 0;
+    }
+
+    inline bool registered() const noexcept
+    {
+        return fixed_;
+    }
+
+    /// <summary>
+    /// 自 open 以来以 IORING_OP_READ_FIXED 与 IORING_OP_READ 提交的读取次数（含短读后的续读）
+    /// </summary>
+    inline ::std::size_t fixed_reads() const noexcept
+    {
+        return fixed_reads_;
+    }
+
+    inline ::std::size_t plain_reads() const noexcept
+    {
+        return plain_reads_;
+    }
+
+    inline unsigned depth() const noexcept
+    {
+        return depth_;
+    }
+
+    inline ::std::size_t buffer_size() const noexcept
+    {
+        return buffer_size_;
+    }
+
+    /// <summary>
+    /// 读取所有请求，每个完成时调用 on_complete(read_request const&, ::std::span<::std::byte>, nbt_error)。
+    /// 完成顺序不一定是提交顺序；短读会自动续读，提前到达文件末尾时为 end_of_file，
+    /// 读取失败或 length 超过 buffer_size 时为 invalid。返回 false 表示 ring 本身出错，此时 ring 已关闭，未完成的请求不会回调
+    /// </summary>
+    inline bool read_batch(::std::span<read_request const> requests, auto&& on_complete) noexcept
+    {
+        if (ring_fd_ < 0) [[unlikely]]
+            return false;
+        ::std::size_t next{0};
+        unsigned inflight{0};
+        unsigned unsubmitted{0};
+        while (next < requests.size() || inflight != 0)
+        {
+            while (next < requests.size() && !free_.empty())
+            {
+                auto const& request{requests[next++]};
+                if (request.length > buffer_size_ || request.fd < 0) [[unlikely]]
+                {
+                    on_complete(request, ::std::span<::std::byte>{}, nbt_error::invalid);
+                    continue;
+                }
+                auto const index{free_.back()};
+                free_.pop_back();
+                slots_[index] = slot{request, 0};
+                prepare(index);
+                inflight++;
+                unsubmitted++;
+            }
+            if (inflight == 0)
+                break;
+            auto const submitted{::syscall(__NR_io_uring_enter, ring_fd_, unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0)};
+            if (submitted < 0)
+            {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                    continue;
+                close();
+                return false;
+            }
+            unsubmitted -= static_cast<unsigned>(submitted);
+            auto head{load_u32(params_.cq_off.head, cq_ring_, ::std::memory_order_relaxed)};
+            auto const tail{load_u32(params_.cq_off.tail, cq_ring_, ::std::memory_order_acquire)};
+            auto const mask{*ring_u32(params_.cq_off.ring_mask, cq_ring_)};
+            auto const cqes{reinterpret_cast<::io_uring_cqe*>(static_cast<::std::byte*>(cq_ring_) + params_.cq_off.cqes)};
+            for (; head != tail; head++)
+            {
+                auto const& cqe{cqes[head & mask]};
+                auto const index{static_cast<unsigned>(cqe.user_data)};
+                auto& current{slots_[index]};
+                auto const data{buffers_ + index * buffer_size_};
+                nbt_error result{nbt_error::ok};
+                if (cqe.res < 0)
+                {
+                    if (cqe.res == -EAGAIN || cqe.res == -EINTR)
+                    {
+                        prepare(index);
+                        unsubmitted++;
+                        continue;
+                    }
+                    result = nbt_error::invalid;
+                }
+                else
+                {
+                    current.done += static_cast<::std::uint32_t>(cqe.res);
+                    if (current.done < current.request.length)
+                    {
+                        if (cqe.res != 0)
+                        {
+                            // 短读：在同一槽位续读剩余部分
+                            prepare(index);
+                            unsubmitted++;
+                            continue;
+                        }
+                        result = nbt_error::end_of_file;
+                    }
+                }
+                on_complete(current.request, ::std::span<::std::byte>{data, result == nbt_error::invalid ? 0 : current.done}, result);
+                free_.push_back(index);
+                inflight--;
+            }
+            store_u32(params_.cq_off.head, cq_ring_, head);
+        }
+        return true;
+    }
+
+private:
+    struct slot
+    {
+        read_request request;
+        ::std::uint32_t done;
+    };
+
+    inline static bool fail(nbt_error& error_code) noexcept
+    {
+        error_code = nbt_error::invalid;
+        return false;
+    }
+
+    inline bool abandon(nbt_error& error_code) noexcept
+    {
+        close();
+        return fail(error_code);
+    }
+
+    inline static ::std::uint32_t* ring_u32(::std::uint32_t offset, void* ring) noexcept
+    {
+        return reinterpret_cast<::std::uint32_t*>(static_cast<::std::byte*>(ring) + offset);
+    }
+
+    inline static ::std::uint32_t load_u32(::std::uint32_t offset, void* ring, ::std::memory_order order) noexcept
+    {
+        return ::std::atomic_ref<::std::uint32_t>{*ring_u32(offset, ring)}.load(order);
+    }
+
+    inline static void store_u32(::std::uint32_t offset, void* ring, ::std::uint32_t value) noexcept
+    {
+        ::std::atomic_ref<::std::uint32_t>{*ring_u32(offset, ring)}.store(value, ::std::memory_order_release);
+    }
+
+    /// <summary>
+    /// 为槽位 index 填写一个 SQE，读取尚未完成的部分；SQ 与槽位一样多，不会溢出
+    /// </summary>
+    inline void prepare(unsigned index) noexcept
+    {
+        auto const& current{slots_[index]};
+        auto const tail{load_u32(params_.sq_off.tail, sq_ring_, ::std::memory_order_relaxed)};
+        auto const position{tail & *ring_u32(params_.sq_off.ring_mask, sq_ring_)};
+        auto& sqe{sqes_[position]};
+        sqe = ::io_uring_sqe{};
+        sqe.opcode = fixed_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        (fixed_ ? fixed_reads_ : plain_reads_)++;
+        sqe.fd = current.request.fd;
+        sqe.off = current.request.offset + current.done;
+        sqe.addr = reinterpret_cast<::std::uint64_t>(buffers_ + index * buffer_size_ + current.done);
+        sqe.len = current.request.length - current.done;
+        sqe.buf_index = static_cast<::std::uint16_t>(index);
+        sqe.user_data = index;
+        ring_u32(params_.sq_off.array, sq_ring_)[position] = position;
+        store_u32(params_.sq_off.tail, sq_ring_, tail + 1);
+    }
+
+    int ring_fd_{-1};
+    ::io_uring_params params_{};
+    void* sq_ring_{nullptr};
+    void* cq_ring_{nullptr};
+    ::io_uring_sqe* sqes_{nullptr};
+    ::std::size_t sq_size_{0};
+    ::std::size_t cq_size_{0};
+    ::std::size_t sqes_size_{0};
+    ::std::byte* buffers_{nullptr};
+    ::std::size_t buffer_size_{0};
+    unsigned depth_{0};
+    bool fixed_{false};
+    ::std::size_t fixed_reads_{0};
+    ::std::size_t plain_reads_{0};
+    ::std::vector<slot> slots_{};
+    ::std::vector<unsigned> free_{};
+};
+
+/// <summary>
+/// 读取 region 文件中一个 chunk 占用的全部扇区；数据以 5 字节 chunk 头部开始，完成后用 region::chunk_from_sectors 取出 chunk
+/// </summary>
+inline read_request chunk_read_request(int fd, region::chunk_location location, ::std::uint64_t tag) noexcept
+{
+    return read_request{fd, static_cast<::std::uint64_t>(location.sector_offset) * region::sector_size, static_cast<::std::uint32_t>(location.sector_count * region::sector_size), tag};
+}
+
+/// <summary>
+/// 读取 chunk_read_request 生成的请求，每个完成的扇区交给 target 的解压与反序列化阶段，调用线程只做 I/O。
+/// target 的回调收到的 chunk_request 中 file 为空、index 为 0，用 tag 区分 chunk；读取失败的请求同样到达回调。
+/// 返回 false 表示 ring 出错，未完成的请求不会提交
+/// </summary>
+template<typename T, any_option Option, typename Decompressor, ::std::size_t Depth>
+inline bool read_chunks(uring_reader& reader, ::std::span<read_request const> requests, region::pipeline<T, Option, Decompressor, Depth>& target) noexcept
+{
+    return reader.read_batch(requests, [&target](read_request const& request, ::std::span<::std::byte> data, nbt_error error_code) {
+        // 文件末尾的最后一个扇区可能不完整，是否缺少数据由 chunk 头部中的长度判断
+        if (error_code == nbt_error::end_of_file && !data.empty())
+            error_code = nbt_error::ok;
+        target.submit_sectors(region::chunk_request{nullptr, 0, request.tag}, data, error_code);
+    });
+}
+
+/// <summary>
+/// 批量读取多个完整的 NBT 文件（例如玩家 .dat），按魔数解压后反序列化为 T，
+/// 完成时调用 on_document(::std::size_t path_index, T&, nbt_error)。每次只打开 depth 个文件，
+/// 大于 buffer_size 的文件为 invalid。字符串与 view 只在回调期间有效
+/// </summary>
+template<typename T, any_option Option = option<>, typename Decompressor = region::default_decompressor>
+inline bool load_documents(uring_reader& reader, ::std::span<char const* const> paths, auto&& on_document)
+{
+    Decompressor decompressor{};
+    ::std::vector<read_request> batch{};
+    for (::std::size_t first{0}; first < paths.size(); first += reader.depth())
+    {
+        auto const last{first + reader.depth() < paths.size() ? first + reader.depth() : paths.size()};
+        batch.clear();
+        for (auto i{first}; i < last; i++)
+        {
+            auto const fd{::open(paths[i], O_RDONLY | O_CLOEXEC)};
+            struct stat st{};
+            if (fd >= 0 && ::fstat(fd, &st) == 0 && static_cast<::std::size_t>(st.st_size) <= reader.buffer_size())
+            {
+                batch.push_back(read_request{fd, 0, static_cast<::std::uint32_t>(st.st_size), i});
+                continue;
+            }
+            if (fd >= 0)
+                ::close(fd);
+            T value{};
+            on_document(i, value, nbt_error::invalid);
+        }
+        auto const completed{reader.read_batch(batch, [&](read_request const& request, ::std::span<::std::byte> data, nbt_error error_code) {
+            T value{};
+            if (error_code == nbt_error::ok)
+            {
+                ::std::span<::std::byte const> raw{data};
+                auto const format{detect_compression(raw)};
+                ::std::span<::std::byte> inflated{};
+                if (format != compression::none)
+                {
+                    if (decompressor.decompress(raw, format, inflated, error_code))
+                        raw = inflated;
+                    else if (error_code == nbt_error::ok)
+                        error_code = nbt_error::invalid;
+                }
+                if (error_code == nbt_error::ok && !na::serializer::deserialize<nbt, Option>(value, raw, error_code) && error_code == nbt_error::ok)
+                    error_code = nbt_error::invalid;
+            }
+            on_document(static_cast<::std::size_t>(request.tag), value, error_code);
+        })};
+        for (auto const& request : batch)
+            ::close(request.fd);
+        if (!completed)
+            return false;
+    }
+    return true;
+}
+}  // namespace na::nbt
\ No newline at end of file
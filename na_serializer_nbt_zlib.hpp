@@ -0,0 +1,310 @@
+#pragma once
+#include "na_serializer.hpp"
+#include "na_serializer_nbt.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
+#include <zlib.h>
+
+namespace na::nbt {
+/// <summary>
+/// 可重复使用的解压器：z_stream 与输出缓冲区在多次调用之间保留，缓冲区只增不减。
+/// gzip 输入按尾部的 ISIZE 一次分配到位后一次解压完成；zlib 没有长度信息，从上次的大小或 size_hint 开始按倍数扩容。
+/// 解压结果（以及从中反序列化出的字符串与 view）在下一次调用前有效
+/// </summary>
+struct inflater
+{
+    inline inflater() noexcept = default;
+
+    inline explicit inflater(::std::size_t size_hint) noexcept : size_hint_{size_hint}
+    {}
+
+    inflater(inflater const&) = delete;
+    inflater& operator=(inflater const&) = delete;
+
+    inline ~inflater() noexcept
+    {
+        if (initialized_)
+            inflateEnd(&stream_);
+    }
+
+    /// <summary>
+    /// 解压 input；未压缩的输入原样返回而不复制
+    /// </summary>
+    inline bool decompress(::std::span<::std::byte const> input, ::std::span<::std::byte const>& output, nbt_error& error_code) noexcept
+    {
+        auto const format{detect_compression(input)};
+        if (format == compression::none)
+        {
+            output = input;
+            return true;
+        }
+        ::std::span<::std::byte> result{};
+        if (!decompress(input, format, result, error_code))
+            return false;
+        output = result;
+        return true;
+    }
+
+    /// <summary>
+    /// 按指定格式解压到内部缓冲区，输出可写，可以交给 deserialize_inplace
+    /// </summary>
+    inline bool decompress(::std::span<::std::byte const> input, compression format, ::std::span<::std::byte>& output, nbt_error& error_code) noexcept
+    {
+        return decompress(input, format, buffer_, output, error_code);
+    }
+
+    /// <summary>
+    /// 解压到调用方的 buffer；流水线用它把解压结果连同缓冲区一起交给反序列化线程
+    /// </summary>
+    inline bool decompress(::std::span<::std::byte const> input, compression format, decompress_buffer& buffer, ::std::span<::std::byte>& output, nbt_error& error_code) noexcept
+    {
+        if (format == compression::none)
+        {
+            if (!buffer.reserve(input.size(), 0))
+                return fail(error_code, nbt_error::invalid);
+            if (!input.empty())
+                ::std::memcpy(buffer.data.get(), input.data(), input.size());
+            output = ::std::span<::std::byte>{buffer.data.get(), input.size()};
+            return true;
+        }
+        if (input.size() > ::std::numeric_limits<uInt>::max()) [[unlikely]]
+            return fail(error_code, nbt_error::invalid);
+        if (!reset()) [[unlikely]]
+            return fail(error_code, nbt_error::invalid);
+
+        auto expected{size_hint_ > last_size_ ? size_hint_ : last_size_};
+        if (format == compression::gzip && input.size() >= 18)
+        {
+            // ISIZE 是原始长度对 2^32 取模，小端，位于最后 4 字节；多成员 gzip 时只是最后一个成员的长度，不足时下面照常扩容
+            ::std::uint32_t isize{};
+            ::std::memcpy(&isize, input.data() + input.size() - 4, 4);
+            if constexpr (::std::endian::native == ::std::endian::big)
+                isize = ::std::byteswap(isize);
+            expected = isize;
+        }
+        // deflate 的压缩比不超过约 1032:1，避免伪造的 ISIZE 造成过量分配
+        if (expected > input.size() * 1032)
+            expected = input.size() * 1032;
+        if (expected == 0)
+            expected = input.size() * 4;
+
+        stream_.next_in = reinterpret_cast<Bytef*>(const_cast<::std::byte*>(input.data()));
+        stream_.avail_in = static_cast<uInt>(input.size());
+        ::std::size_t produced{0};
+        // 多出 1 字节使 ISIZE 准确时也能在同一次调用中看到 Z_STREAM_END
+        auto capacity{expected + 1};
+        while (true)
+        {
+            if (!buffer.reserve(capacity, produced)) [[unlikely]]
+                return fail(error_code, nbt_error::invalid);
+            auto const room{buffer.capacity - produced};
+            stream_.next_out = reinterpret_cast<Bytef*>(buffer.data.get() + produced);
+            stream_.avail_out = static_cast<uInt>(room > ::std::numeric_limits<uInt>::max() ? ::std::numeric_limits<uInt>::max() : room);
+            auto const before{stream_.avail_out};
+            auto const ret{::inflate(&stream_, Z_FINISH)};
+            produced += before - stream_.avail_out;
+            if (ret == Z_STREAM_END)
+            {
+                if (stream_.avail_in == 0)
+                    break;
+                // gzip 允许多个成员首尾相接，解压结果依次拼接；zlib 流之后不应再有数据
+                if (format != compression::gzip || inflateReset(&stream_) != Z_OK) [[unlikely]]
+                    return fail(error_code, nbt_error::invalid);
+                continue;
+            }
+            if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR) [[unlikely]]
+                return fail(error_code, nbt_error::invalid);
+            if (stream_.avail_in == 0 && stream_.avail_out != 0) [[unlikely]]
+                return fail(error_code, nbt_error::end_of_file);
+            capacity = buffer.capacity * 2;
+        }
+        last_size_ = produced;
+        output = ::std::span<::std::byte>{buffer.data.get(), produced};
+        return true;
+    }
+
+    inline ::std::size_t capacity() const noexcept
+    {
+        return buffer_.capacity;
+    }
+
+private:
+    inline static bool fail(nbt_error& error_code, nbt_error value) noexcept
+    {
+        error_code = value;
+        return false;
+    }
+
+    inline bool reset() noexcept
+    {
+        if (initialized_)
+            return inflateReset(&stream_) == Z_OK;
+        stream_ = z_stream{};
+        // 32 表示自动识别 gzip 与 zlib 头部
+        initialized_ = inflateInit2(&stream_, 15 + 32) == Z_OK;
+        return initialized_;
+    }
+
+    z_stream stream_{};
+    bool initialized_{false};
+    decompress_buffer buffer_{};
+    ::std::size_t size_hint_{0};
+    ::std::size_t last_size_{0};
+};
+
+/// <summary>
+/// 可重复使用的压缩器：serialize_compressed 以固定大小的窗口分段序列化，每个窗口直接送入 deflate，
+/// 压缩结果按 output_size 大小的块交给调用方，不会先生成完整的未压缩文档。
+/// z_stream 与两个缓冲区在多次调用之间保留；fast_level 适合自动保存这类突发的大量写入
+/// </summary>
+struct deflater
+{
+    constexpr static int default_level = Z_DEFAULT_COMPRESSION;
+    constexpr static int fast_level = Z_BEST_SPEED;
+    constexpr static int best_level = Z_BEST_COMPRESSION;
+
+    constexpr static ::std::size_t default_window_size = 64 * 1024;
+    constexpr static ::std::size_t default_output_size = 16 * 1024;
+
+    inline explicit deflater(compression format = compression::gzip, int level = default_level, ::std::size_t window_size = default_window_size, ::std::size_t output_size = default_output_size) noexcept
+      : format_{format}, level_{level}, window_size_{window_size}, output_size_{output_size}
+    {}
+
+    deflater(deflater const&) = delete;
+    deflater& operator=(deflater const&) = delete;
+
+    inline ~deflater() noexcept
+    {
+        if (initialized_)
+            deflateEnd(&stream_);
+    }
+
+    inline compression format() const noexcept
+    {
+        return format_;
+    }
+
+    inline int level() const noexcept
+    {
+        return level_;
+    }
+
+    /// <summary>
+    /// 开始一个新文档；format 为 none 时 write 原样输出
+    /// </summary>
+    inline bool begin() noexcept
+    {
+        // 两个缓冲区各自分配，上次只分配成功一个时这里补上另一个
+        if (!window_)
+            window_.reset(new (::std::nothrow)::std::byte[window_size_]);
+        if (!output_)
+            output_.reset(new (::std::nothrow)::std::byte[output_size_]);
+        if (!window_ || !output_) [[unlikely]]
+            return false;
+        if (format_ == compression::none)
+            return true;
+        if (initialized_)
+            return deflateReset(&stream_) == Z_OK;
+        stream_ = z_stream{};
+        // 16 表示写 gzip 头部与尾部
+        initialized_ = deflateInit2(&stream_, level_, Z_DEFLATED, format_ == compression::gzip ? 15 + 16 : 15, 9, Z_DEFAULT_STRATEGY) == Z_OK;
+        return initialized_;
+    }
+
+    /// <summary>
+    /// 压缩一段未压缩数据，finish 为 true 时结束文档；压缩结果交给 sink
+    /// </summary>
+    inline bool write(::std::span<::std::byte const> input, bool finish, auto&& sink) noexcept
+    {
+        if (format_ == compression::none)
+            return input.empty() || sink(input);
+        if (input.size() > ::std::numeric_limits<uInt>::max()) [[unlikely]]
+            return false;
+        stream_.next_in = reinterpret_cast<Bytef*>(const_cast<::std::byte*>(input.data()));
+        stream_.avail_in = static_cast<uInt>(input.size());
+        while (true)
+        {
+            stream_.next_out = reinterpret_cast<Bytef*>(output_.get());
+            stream_.avail_out = static_cast<uInt>(output_size_);
+            auto const ret{deflate(&stream_, finish ? Z_FINISH : Z_NO_FLUSH)};
+            if (ret == Z_STREAM_ERROR) [[unlikely]]
+                return false;
+            auto const produced{output_size_ - stream_.avail_out};
+            if (produced != 0 && !sink(::std::span<::std::byte const>{output_.get(), produced}))
+                return false;
+            if (finish ? ret == Z_STREAM_END : (stream_.avail_in == 0 && stream_.avail_out != 0))
+                return true;
+        }
+    }
+
+    inline ::std::span<::std::byte> window() const noexcept
+    {
+        return {window_.get(), window_size_};
+    }
+
+private:
+    compression format_;
+    int level_;
+    ::std::size_t window_size_;
+    ::std::size_t output_size_;
+    z_stream stream_{};
+    bool initialized_{false};
+    ::std::unique_ptr<::std::byte[]> window_{};
+    ::std::unique_ptr<::std::byte[]> output_{};
+};
+
+/// <summary>
+/// 序列化并压缩，压缩结果分块交给 sink（bool(::std::span<::std::byte const>)）。length 为未压缩的文档长度
+/// </summary>
+template<any_option Option = option<>>
+inline bool serialize_compressed(auto const& value, deflater& state, auto&& sink, ::std::size_t& length, nbt_error& error_code)
+{
+    if (!state.begin()) [[unlikely]]
+    {
+        error_code = nbt_error::invalid;
+        return false;
+    }
+    auto const compress{[&](::std::span<::std::byte const> piece) { return state.write(piece, false, sink); }};
+    if (!na::serializer::serialize_windowed<nbt, Option>(value, state.window(), compress, length, error_code))
+        return false;
+    if (!state.write({}, true, sink)) [[unlikely]]
+    {
+        error_code = nbt_error::invalid;
+        return false;
+    }
+    return true;
+}
+
+/// <summary>
+/// 序列化并压缩到 memory_builder 末尾，builder 可在多次调用之间 clear 后复用
+/// </summary>
+template<any_option Option = option<>, ::std::size_t InlineCapacity, typename Allocator>
+inline bool serialize_compressed(auto const& value, deflater& state, na::serializer::memory_builder<InlineCapacity, Allocator>& builder, nbt_error& error_code)
+{
+    ::std::size_t length{0};
+    return serialize_compressed<Option>(
+        value, state, [&builder](::std::span<::std::byte const> piece) {
+            builder.append(piece);
+            return true;
+        },
+        length, error_code);
+}
+
+/// <summary>
+/// 解压后反序列化；未压缩的输入直接反序列化。字符串与 view 引用 state 的缓冲区
+/// </summary>
+template<any_option Option = option<>>
+inline bool deserialize_compressed(auto& value, ::std::span<::std::byte const> input, inflater& state, nbt_error& error_code) noexcept
+{
+    ::std::span<::std::byte const> raw{};
+    if (!state.decompress(input, raw, error_code))
+        return false;
+    return na::serializer::deserialize<nbt, Option>(value, raw, error_code);
+}
+}  // namespace na::nbt
\ No newline at end of file
@@ -1,6 +1,20 @@
 ﻿// #include "../fast_io/include/fast_io.h"
 #include "na_serializer.hpp"
+#include "na_serializer_async.hpp"
 #include "na_serializer_nbt.hpp"
+#include "na_serializer_nbt_region.hpp"
+#include "na_serializer_nbt_scan.hpp"
+#include "na_serializer_nbt_pipeline.hpp"
+#ifdef __linux__
+    #include "na_serializer_nbt_uring.hpp"
+#endif
+#ifdef NA_SERIALIZER_HAS_ZLIB
+    #include "na_serializer_nbt_zlib.hpp"
+#endif
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <cstring>
 
 struct test_type
 {
@@ -9,6 +23,19 @@ struct test_type
     std::int16_t i16;
     double dbl;
 };
+struct test_type_reordered
+{
+    double dbl;
+    std::int16_t i16;
+    std::int8_t i8;
+    std::int64_t i64;
+};
+struct test_type_missing
+{
+    double dbl;
+    std::int16_t i16;
+    std::int8_t i8;
+};
 struct simple_test
 {
     std::int8_t mem1;
@@ -24,6 +51,67 @@ struct outer_type
     na::nbt::nbt_list<double, 4> li2;
     std::int64_t i64_8;
 };
+struct outer_subset
+{
+    na::nbt::nbt_list<double, 4> li2;
+    std::int64_t i64_8;
+};
+struct outer_dynamic
+{
+    std::int8_t i8;
+    test_type tt;
+    na::nbt::nbt_dynamic_list<simple_test> ls;
+    na::nbt::nbt_string t_string;
+    na::nbt::nbt_dynamic_list<double> li2;
+    std::int64_t i64_8;
+};
+struct dynamic_array_test
+{
+    na::nbt::nbt_dynamic_int_array<> ints;
+    na::nbt::nbt_dynamic_list<na::nbt::nbt_string> names;
+    na::nbt::nbt_dynamic_long_array<> longs;
+};
+struct outer_pmr
+{
+    std::int8_t i8;
+    test_type tt;
+    na::nbt::pmr::nbt_dynamic_list<simple_test> ls;
+    na::nbt::nbt_string t_string;
+    na::nbt::pmr::nbt_dynamic_list<double> li2;
+    std::int64_t i64_8;
+};
+struct bulk_array_test
+{
+    na::nbt::nbt_long_array<37> longs;
+    na::nbt::nbt_list<std::int16_t, 37> shorts;
+    na::nbt::nbt_dynamic_int_array<> ints;
+    na::nbt::nbt_dynamic_list<float> floats;
+};
+struct byte_payload_test
+{
+    na::nbt::nbt_byte light;
+    na::nbt::nbt_byte_array<5> biomes;
+    na::nbt::nbt_list<na::nbt::nbt_byte, 3> flags;
+};
+struct bulk_array_view_test
+{
+    na::nbt::nbt_long_array_view<> longs;
+    na::nbt::nbt_list_view<std::int16_t> shorts;
+    na::nbt::nbt_int_array_view<> ints;
+    na::nbt::nbt_list_view<float> floats;
+};
+struct bulk_array_inplace_test
+{
+    na::nbt::nbt_long_array_view<std::endian::native> longs;
+    na::nbt::nbt_list_view<std::int16_t, std::endian::native> shorts;
+    na::nbt::nbt_int_array_view<std::endian::native> ints;
+    na::nbt::nbt_list_view<float, std::endian::native> floats;
+};
+struct string_list_test
+{
+    na::nbt::nbt_list<na::nbt::nbt_string, 2> names;
+    std::int16_t tail;
+};
 
 int main()
 {
@@ -34,5 +122,1079 @@ int main()
         na::nbt::nbt_error errc{};
         auto ret{na::serializer::deserialize<na::nbt::nbt, na::nbt::option<std::endian::big>>(value, std::as_bytes(buf), errc)};
         // fast_io::io::println(fast_io::u8out(), fast_io::mnp::boolalpha(ret), " ", value.i8, " ", value.tt.i8, " ", value.tt.i64, " ", value.tt.i16, " ", value.tt.dbl, " ", value.t_string, " ", value.li2[0], " ", value.li2[1], " ", value.li2[2], " ", value.li2[3], " ", value.i64_8);
+        if (!ret)
+            return 1;
+
+        std::array<std::byte, 253> out{};
+        std::size_t length{};
+        auto ret2{na::serializer::serialize<na::nbt::nbt, na::nbt::option<std::endian::big>>(value, std::span{out}, length, errc)};
+        if (!ret2 || length != arr.size() || std::memcmp(out.data(), arr.data(), arr.size()) != 0)
+            return 2;
+        std::array<std::byte, 253> out_short_form{};
+        if (!na::serializer::serialize<na::nbt::nbt, na::nbt::option<std::endian::big>>(value, std::span{out_short_form}, errc) || out_short_form != out)
+            return 2;
+        std::array<std::byte, 8> too_small{};
+        errc = na::nbt::nbt_error::ok;
+        if (na::serializer::serialize<na::nbt::nbt, na::nbt::option<std::endian::big>>(value, std::span{too_small}, length, errc) || errc != na::nbt::nbt_error::end_of_file)
+            return 2;
+        if (na::serializer::serialized_size<na::nbt::nbt, na::nbt::option<std::endian::big>>(value) != arr.size())
+            return 4;
+
+        na::serializer::memory_builder<16> builder;
+        for (std::size_t i = 0; i < 3; i++)
+        {
+            if (!na::serializer::serialize<na::nbt::nbt, na::nbt::option<std::endian::big>>(value, builder, errc) || builder.size() != arr.size() * (i + 1))
+                return 7;
+        }
+        std::array<std::byte, 253 * 3> out3{};
+        builder.copy_to(out3.data());
+        if (builder.size() != out3.size())
+            return 8;
+        for (std::size_t i = 0; i < 3; i++)
+        {
+            if (std::memcmp(out3.data() + arr.size() * i, arr.data(), arr.size()) != 0)
+                return 8;
+        }
+
+        // 长度在运行时确定的 list 与定长 list 的编码相同
+        outer_dynamic dyn{};
+        std::size_t consumed{};
+        if (!na::serializer::deserialize<na::nbt::nbt, na::nbt::option<std::endian::big>>(dyn, std::as_bytes(buf), consumed, errc) || consumed != arr.size() || dyn.ls.size() != 3 || dyn.li2.size() != 4 || dyn.ls[2].mem1 != 3 || dyn.li2[3] != value.li2[3])
+            return 14;
+        std::array<std::byte, 253> out_dyn{};
+        if (!na::serializer::serialize<na::nbt::nbt, na::nbt::option<std::endian::big>>(dyn, std::span{out_dyn}, length, errc) || length != arr.size() || std::memcmp(out_dyn.data(), arr.data(), arr.size()) != 0)
+            return 15;
+
+        // 所有变长数据都从调用方的 arena 分配，上游为 null_memory_resource 保证没有落到默认堆上
+        alignas(std::max_align_t) std::array<std::byte, 512> arena_buffer{};
+        std::pmr::monotonic_buffer_resource arena{arena_buffer.data(), arena_buffer.size(), std::pmr::null_memory_resource()};
+        {
+            outer_pmr pmr_value{};
+            na::serializer::allocation_context allocation{&arena};
+            if (!na::serializer::deserialize<na::nbt::nbt, na::nbt::option<std::endian::big>>(pmr_value, std::as_bytes(buf), consumed, allocation, errc) || pmr_value.ls.size() != 3 || pmr_value.ls.get_allocator().resource() != &arena || pmr_value.li2[3] != value.li2[3])
+                return 18;
+        }
+        arena.release();
+        {
+            // arena 容不下合法文档时以 invalid 返回，而不是让 bad_alloc 穿过 noexcept
+            alignas(std::max_align_t) std::array<std::byte, 16> small_buffer{};
+            std::pmr::monotonic_buffer_resource small_arena{small_buffer.data(), small_buffer.size(), std::pmr::null_memory_resource()};
+            outer_pmr pmr_value{};
+            na::serializer::allocation_context allocation{&small_arena};
+            errc = {};
+            if (na::serializer::deserialize<na::nbt::nbt, na::nbt::option<std::endian::big>>(pmr_value, std::as_bytes(buf), consumed, allocation, errc) || errc != na::nbt::nbt_error::invalid)
+                return 18;
+            // 允许字段乱序时快速路径失败后由 tolerant_decoder 重新分配，同样以 invalid 返回
+            small_arena.release();
+            outer_pmr tolerant_value{};
+            errc = {};
+            if (na::serializer::deserialize<na::nbt::nbt, na::nbt::option<std::endian::big, true>>(tolerant_value, std::as_bytes(buf), consumed, allocation, errc) || errc != na::nbt::nbt_error::invalid)
+                return 18;
+        }
+
+        // 名称、tag id、list 长度被篡改时必须拒绝
+        for (std::size_t pos : {std::size_t{7}, std::size_t{61}, std::size_t{66}, std::size_t{96}, std::size_t{200}, std::size_t{252}})
+        {
+            auto bad{arr};
+            bad[pos] ^= 0x10;
+            outer_type value2{};
+            na::nbt::nbt_error errc2{};
+            if (na::serializer::deserialize<na::nbt::nbt, na::nbt::option<std::endian::big>>(value2, std::as_bytes(std::span{bad}), errc2) || errc2 != na::nbt::nbt_error::invalid)
+                return 9;
+        }
+
+        // 只关心部分字段时跳过其余的 compound、list 与字符串
+        outer_subset subset{};
+        if (!na::serializer::deserialize<na::nbt::nbt, na::nbt::option<std::endian::big, true>>(subset, std::as_bytes(buf), errc) || subset.li2[3] != value.li2[3] || subset.i64_8 != value.i64_8)
+            return 11;
+        auto cursor{reinterpret_cast<std::byte const*>(arr.data()) + 3};
+        if (na::nbt::skip_payload(na::nbt::tag_compound, cursor, reinterpret_cast<std::byte const*>(arr.data()) + 3, errc) || errc != na::nbt::nbt_error::end_of_file)
+            return 12;
+        if (!na::nbt::skip_payload(na::nbt::tag_compound, cursor, reinterpret_cast<std::byte const*>(arr.data()) + arr.size(), errc) || cursor != reinterpret_cast<std::byte const*>(arr.data()) + arr.size())
+            return 13;
+
+        // 只读取少数字段：之前的变长节点只被跳过，不构造对象
+        na::serializer::lazy<na::nbt::nbt, na::nbt::option<>, outer_dynamic> lazy{std::as_bytes(buf)};
+        std::int64_t lazy_i64{};
+        na::nbt::nbt_string lazy_string{};
+        double lazy_dbl{};
+        test_type lazy_tt{};
+        na::nbt::nbt_dynamic_list<simple_test> lazy_ls{};
+        // 成员下标不需要构造对象，没有 constexpr 构造函数的 pmr 容器也可以
+        using pmr_node = na::serializer::node<na::nbt::nbt, na::nbt::option<>, na::serializer::serializer_profile<na::serializer::operations::serialize>, na::serializer::node_path<outer_pmr>>;
+        static_assert(pmr_node::member_index<&outer_pmr::i8> == 0 && pmr_node::member_index<&outer_pmr::li2> == 4 && pmr_node::member_index<&outer_pmr::i64_8> == 5);
+        if (!lazy.get<&outer_dynamic::i64_8>(lazy_i64, errc) || lazy_i64 != value.i64_8 || !lazy.get<&outer_dynamic::t_string>(lazy_string, errc) || lazy_string != value.t_string)
+            return 28;
+        if (!lazy.get<na::serializer::node_path<outer_dynamic, na::serializer::node_index<1>, na::serializer::node_index<3>>>(lazy_dbl, errc) || lazy_dbl != value.tt.dbl || !lazy.get<&outer_dynamic::tt>(lazy_tt, errc) || lazy_tt.i64 != value.tt.i64)
+            return 28;
+        if (!lazy.get<na::serializer::node_index<2>>(lazy_ls, errc) || lazy_ls.size() != 3 || lazy_ls[1].mem1 != 2)
+            return 28;
+        na::serializer::lazy<na::nbt::nbt, na::nbt::option<>, outer_type> lazy_fixed{std::as_bytes(buf)};
+        na::nbt::nbt_list<double, 4> lazy_li2{};
+        if (!lazy_fixed.get<&outer_type::li2>(lazy_li2, errc) || lazy_li2 != value.li2)
+            return 28;
+        auto bad{arr};
+        bad[197] ^= 0x10;
+        na::serializer::lazy<na::nbt::nbt, na::nbt::option<>, outer_dynamic> lazy_bad{std::as_bytes(std::span{bad})};
+        if (lazy_bad.get<&outer_dynamic::i64_8>(lazy_i64, errc) || errc != na::nbt::nbt_error::invalid)
+            return 28;
+        // 不足最小长度的输入是 end_of_file
+        na::serializer::lazy<na::nbt::nbt, na::nbt::option<>, outer_dynamic> lazy_short{std::as_bytes(buf).first(10)};
+        errc = na::nbt::nbt_error::ok;
+        if (lazy_short.get<&outer_dynamic::i64_8>(lazy_i64, errc) || errc != na::nbt::nbt_error::end_of_file)
+            return 28;
+
+        // 按窗口分段输出，窗口放不下的单个 step 临时单独分配
+        for (std::size_t window_size : {std::size_t{16}, std::size_t{100}, std::size_t{512}})
+        {
+            std::vector<std::byte> window(window_size);
+            std::vector<std::byte> joined{};
+            std::size_t windowed_length{};
+            auto const sink{[&](std::span<std::byte const> piece) {
+                joined.insert(joined.end(), piece.begin(), piece.end());
+                return true;
+            }};
+            if (!na::serializer::serialize_windowed<na::nbt::nbt, na::nbt::option<>>(dyn, std::span{window}, sink, windowed_length, errc) || windowed_length != arr.size() || joined.size() != arr.size() || std::memcmp(joined.data(), arr.data(), arr.size()) != 0)
+                return 34;
+        }
+        // sink 拒绝时以 invalid 失败：16 字节窗口在中途拒绝，512 字节窗口在最后一次输出时拒绝
+        for (std::size_t window_size : {std::size_t{16}, std::size_t{512}})
+        {
+            std::vector<std::byte> window(window_size);
+            std::size_t windowed_length{};
+            errc = na::nbt::nbt_error::ok;
+            if (na::serializer::serialize_windowed<na::nbt::nbt, na::nbt::option<>>(dyn, std::span{window}, [](std::span<std::byte const>) { return false; }, windowed_length, errc) || errc != na::nbt::nbt_error::invalid)
+                return 34;
+        }
+
+        // 分块到达的输入：每块之后从停下的 step 继续
+        for (std::size_t piece : {std::size_t{1}, std::size_t{7}, std::size_t{64}})
+        {
+            outer_dynamic streamed{};
+            std::array<std::byte, 512> storage{};
+            na::serializer::stream_decoder<na::nbt::nbt, na::nbt::option<>, outer_dynamic> decoder{streamed, std::span{storage}};
+            auto status{na::serializer::stream_status::need_more};
+            for (std::size_t pos{0}; pos < arr.size() && status == na::serializer::stream_status::need_more; pos += piece)
+                status = decoder.feed(std::as_bytes(buf).subspan(pos, std::min(piece, arr.size() - pos)), errc);
+            if (status != na::serializer::stream_status::done || decoder.length() != arr.size() || streamed.ls.size() != 3 || streamed.ls[2].longmm != dyn.ls[2].longmm || streamed.t_string != value.t_string || streamed.li2 != dyn.li2 || streamed.i64_8 != value.i64_8)
+                return 29;
+        }
+        {
+            // 篡改的头部不必等到输入结束就会报错，截断的输入在结束时报错
+            outer_dynamic streamed{};
+            std::array<std::byte, 512> storage{};
+            na::serializer::stream_decoder<na::nbt::nbt, na::nbt::option<>, outer_dynamic> decoder{streamed, std::span{storage}};
+            if (decoder.feed(std::as_bytes(std::span{bad}).first(190), errc) != na::serializer::stream_status::need_more || decoder.feed(std::as_bytes(std::span{bad}).subspan(190, 60), errc) != na::serializer::stream_status::error || errc != na::nbt::nbt_error::invalid)
+                return 30;
+            na::serializer::stream_decoder<na::nbt::nbt, na::nbt::option<>, outer_dynamic> truncated{streamed, std::span{storage}};
+            if (truncated.feed(std::as_bytes(buf).first(250), errc) != na::serializer::stream_status::need_more || truncated.finish(errc) != na::serializer::stream_status::error || errc != na::nbt::nbt_error::end_of_file)
+                return 30;
+
+            // storage 放不下最小长度的文档时立即以 invalid 失败，放不下后续输入时是 end_of_file
+            std::array<std::byte, 8> tiny{};
+            na::serializer::stream_decoder<na::nbt::nbt, na::nbt::option<>, outer_dynamic> undersized{streamed, std::span{tiny}};
+            errc = na::nbt::nbt_error::ok;
+            if (undersized.feed(std::as_bytes(buf).first(4), errc) != na::serializer::stream_status::error || errc != na::nbt::nbt_error::invalid)
+                return 30;
+            std::array<std::byte, 253> exact{};
+            na::serializer::stream_decoder<na::nbt::nbt, na::nbt::option<>, outer_dynamic> overflow{streamed, std::span{exact}};
+            errc = na::nbt::nbt_error::ok;
+            if (overflow.feed(std::as_bytes(buf).first(200), errc) != na::serializer::stream_status::need_more || overflow.feed(std::as_bytes(buf).first(60), errc) != na::serializer::stream_status::error || errc != na::nbt::nbt_error::end_of_file)
+                return 30;
+        }
+        {
+            // 协程接口：模拟的套接字每次最多交付 piece 字节并挂起，由外层循环充当事件循环恢复
+            struct fake_socket
+            {
+                std::span<std::byte const> input;
+                std::size_t piece;
+                std::coroutine_handle<> pending{};
+                std::vector<std::byte> written{};
+
+                struct read_awaiter
+                {
+                    fake_socket& socket;
+                    std::span<std::byte> buffer;
+
+                    bool await_ready() const noexcept
+                    {
+                        return false;
+                    }
+                    void await_suspend(std::coroutine_handle<> handle) noexcept
+                    {
+                        socket.pending = handle;
+                    }
+                    std::size_t await_resume() noexcept
+                    {
+                        auto const n{std::min({socket.piece, buffer.size(), socket.input.size()})};
+                        std::memcpy(buffer.data(), socket.input.data(), n);
+                        socket.input = socket.input.subspan(n);
+                        return n;
+                    }
+                };
+
+                read_awaiter read(std::span<std::byte> buffer) noexcept
+                {
+                    return {*this, buffer};
+                }
+
+                struct write_awaiter
+                {
+                    bool await_ready() const noexcept
+                    {
+                        return true;
+                    }
+                    void await_suspend(std::coroutine_handle<>) const noexcept
+                    {}
+                    bool await_resume() const noexcept
+                    {
+                        return true;
+                    }
+                };
+
+                write_awaiter write(std::span<std::byte const> piece)
+                {
+                    written.insert(written.end(), piece.begin(), piece.end());
+                    return {};
+                }
+            };
+            auto const run{[](auto& task, fake_socket& socket) {
+                std::size_t suspensions{0};
+                for (task.start(); !task.done(); suspensions++)
+                    std::exchange(socket.pending, {}).resume();
+                return suspensions;
+            }};
+            for (std::size_t piece : {std::size_t{1}, std::size_t{13}, std::size_t{512}})
+            {
+                outer_dynamic streamed{};
+                std::array<std::byte, 512> storage{};
+                std::size_t length{};
+                fake_socket socket{std::as_bytes(buf), piece};
+                auto task{na::serializer::async_deserialize<na::nbt::nbt, na::nbt::option<>>(streamed, socket, std::span{storage}, length, errc)};
+                auto const suspensions{run(task, socket)};
+                if (!task.result() || length != arr.size() || suspensions < arr.size() / piece || streamed.ls[2].longmm != dyn.ls[2].longmm || streamed.t_string != value.t_string || streamed.li2 != dyn.li2)
+                    return 46;
+            }
+            {
+                // 输入提前结束
+                outer_dynamic streamed{};
+                std::array<std::byte, 512> storage{};
+                fake_socket socket{std::as_bytes(buf).first(250), 64};
+                auto task{na::serializer::async_deserialize<na::nbt::nbt, na::nbt::option<>>(streamed, socket, std::span{storage}, errc)};
+                run(task, socket);
+                if (task.result() || errc != na::nbt::nbt_error::end_of_file)
+                    return 46;
+            }
+            {
+                fake_socket socket{{}, 0};
+                na::serializer::memory_builder<16> scratch{};
+                auto task{na::serializer::async_serialize<na::nbt::nbt, na::nbt::option<>>(dyn, socket, scratch, errc)};
+                run(task, socket);
+                if (!task.result() || socket.written.size() != arr.size() || std::memcmp(socket.written.data(), arr.data(), arr.size()) != 0)
+                    return 47;
+            }
+        }
+    }
+    {
+        test_type value{-3, 1451, 4, 0.5};
+        constexpr auto size{na::serializer::serialized_size<na::nbt::nbt, na::nbt::option<std::endian::little>>(test_type{})};
+        std::array<std::byte, size> out{};
+        std::size_t length{};
+        na::nbt::nbt_error errc{};
+        auto ret{na::serializer::serialize<na::nbt::nbt, na::nbt::option<std::endian::little>>(value, std::span{out}, length, errc)};
+        test_type value2{};
+        auto ret2{na::serializer::deserialize<na::nbt::nbt, na::nbt::option<std::endian::little>>(value2, std::span<std::byte const>{out.data(), length}, errc)};
+        if (!ret || !ret2 || value2.i8 != -3 || value2.i64 != 1451 || value2.i16 != 4 || value2.dbl != 0.5)
+            return 3;
+        if (length != size)
+            return 5;
+        // 小端下四个标量合并成一个 direct copy step，反序列化时只剩根节点的校验与这一次复制
+        using little_node = na::serializer::node<na::nbt::nbt, na::nbt::option<std::endian::little>, na::serializer::serializer_profile<na::serializer::operations::serialize>, na::serializer::node_path<test_type>>;
+        using little_steps = na::serializer::generate_serialize_step_list<little_node, na::serializer::operations::deserialize>;
+        if (little_steps::size != 2 || little_steps::at<1>::size != 4)
+            return 21;
+
+        // 序列化时同一次复制连同成员的 tag id 与名称一次写出
+        using little_write_steps = na::serializer::generate_serialize_step_list<little_node>;
+        if (little_write_steps::size != 3 || little_write_steps::at<1>::size != 4 || little_write_steps::at<1>::length != na::serializer::total_minimal_size<little_node> - little_node::prepend_minimal_size - little_node::postpend_minimal_size)
+            return 21;
+        if (out[3] != std::byte{na::nbt::tag_byte} || out[9] != std::byte{na::nbt::tag_long})
+            return 21;
+    }
+    {
+        string_list_test value{};
+        value.names[0] = u8"alpha";
+        value.names[1] = u8"be";
+        value.tail = 7;
+        std::array<std::byte, 64> out{};
+        std::size_t length{};
+        na::nbt::nbt_error errc{};
+        auto ret{na::serializer::serialize<na::nbt::nbt, na::nbt::option<>>(value, std::span{out}, length, errc)};
+        string_list_test value2{};
+        auto ret2{na::serializer::deserialize<na::nbt::nbt, na::nbt::option<>>(value2, std::span<std::byte const>{out.data(), length}, errc)};
+        if (!ret || !ret2 || length != na::serializer::serialized_size<na::nbt::nbt, na::nbt::option<>>(value) || value2.names[0] != value.names[0] || value2.names[1] != value.names[1] || value2.tail != 7)
+            return 6;
+    }
+    {
+        dynamic_array_test value{{1, -2, 3}, {u8"a", u8"bcd"}, {}};
+        std::array<std::byte, 128> out{};
+        std::size_t length{};
+        na::nbt::nbt_error errc{};
+        auto ret{na::serializer::serialize<na::nbt::nbt, na::nbt::option<>>(value, std::span{out}, length, errc)};
+        dynamic_array_test value2{};
+        auto ret2{na::serializer::deserialize<na::nbt::nbt, na::nbt::option<>>(value2, std::span<std::byte const>{out.data(), length}, errc)};
+        if (!ret || !ret2 || length != na::serializer::serialized_size<na::nbt::nbt, na::nbt::option<>>(value) || value2.ints != value.ints || value2.names.size() != 2 || value2.names[1] != value.names[1] || !value2.longs.empty())
+            return 16;
+        // 声明的长度超过输入时在分配前拒绝
+        out[10] = std::byte{0x7F};
+        if (na::serializer::deserialize<na::nbt::nbt, na::nbt::option<>>(value2, std::span<std::byte const>{out.data(), length}, errc))
+            return 17;
+    }
+    {
+        // 元素数不是向量宽度的整数倍，覆盖批量转换的尾部
+        bulk_array_test value{};
+        for (int i = 0; i < 37; i++)
+        {
+            value.longs[i] = 0x0102030405060708LL * (i + 1);
+            value.shorts[i] = static_cast<std::int16_t>(0x0102 * (i + 1));
+            value.ints.push_back(0x01020304 * (i + 1));
+            value.floats.push_back(0.5f * i);
+        }
+        std::array<std::byte, 1024> out{};
+        std::size_t length{};
+        na::nbt::nbt_error errc{};
+        auto ret{na::serializer::serialize<na::nbt::nbt, na::nbt::option<>>(value, std::span{out}, length, errc)};
+        // longs 的第二个元素，按大端逐字节写出
+        auto const expect{std::byteswap(static_cast<std::uint64_t>(value.longs[1]))};
+        bulk_array_test value2{};
+        auto ret2{na::serializer::deserialize<na::nbt::nbt, na::nbt::option<>>(value2, std::span<std::byte const>{out.data(), length}, errc)};
+        if (!ret || !ret2 || std::memcmp(out.data() + 3 + 3 + 5 + 4 + 8, &expect, 8) != 0 || value2.longs != value.longs || value2.shorts != value.shorts || value2.ints != value.ints || value2.floats != value.floats)
+            return 19;
+
+        // view 只引用输入，按需读取单个元素或整体复制
+        bulk_array_view_test view{};
+        if (!na::serializer::deserialize<na::nbt::nbt, na::nbt::option<>>(view, std::span<std::byte const>{out.data(), length}, errc) || view.longs.size() != 37 || view.longs[36] != value.longs[36] || view.shorts[5] != value.shorts[5] || view.floats[3] != value.floats[3])
+            return 24;
+        std::array<std::int32_t, 37> ints{};
+        view.ints.copy_to(ints.data());
+        if (!std::equal(ints.begin(), ints.end(), value.ints.begin()))
+            return 24;
+        std::array<std::byte, 1024> out_view{};
+        std::size_t length_view{};
+        if (!na::serializer::serialize<na::nbt::nbt, na::nbt::option<>>(view, std::span{out_view}, length_view, errc) || length_view != length || std::memcmp(out_view.data(), out.data(), length) != 0)
+            return 25;
+
+        // 就地模式把输入缓冲区转换为本机字节序，之后可以直接按类型访问
+        auto buffer{out};
+        bulk_array_inplace_test inplace{};
+        // 失败时缓冲区保持原样
+        if (na::serializer::deserialize_inplace<na::nbt::nbt, na::nbt::option<>>(inplace, std::span{buffer.data(), length - 1}, errc) || std::memcmp(buffer.data(), out.data(), length) != 0)
+            return 26;
+        if (!na::serializer::deserialize_inplace<na::nbt::nbt, na::nbt::option<>>(inplace, std::span{buffer.data(), length}, errc) || inplace.longs.size() != 37 || inplace.longs[36] != value.longs[36] || inplace.shorts[5] != value.shorts[5] || inplace.floats[3] != value.floats[3])
+            return 26;
+        if (std::memcmp(inplace.ints.data(), value.ints.data(), 37 * sizeof(std::int32_t)) != 0)
+            return 26;
+        if (auto const longs{inplace.longs.aligned_span()}; !longs.empty() && !std::equal(longs.begin(), longs.end(), value.longs.begin()))
+            return 26;
+        std::array<std::byte, 1024> out_inplace{};
+        std::size_t length_inplace{};
+        if (!na::serializer::serialize<na::nbt::nbt, na::nbt::option<>>(inplace, std::span{out_inplace}, length_inplace, errc) || length_inplace != length || std::memcmp(out_inplace.data(), out.data(), length) != 0)
+            return 27;
+    }
+    {
+        // 当前机器支持的每个等级都与逐元素实现一致
+        std::array<std::byte, 200> in{};
+        for (std::size_t i = 0; i < in.size(); i++)
+            in[i] = static_cast<std::byte>(i * 7 + 1);
+        auto const max_level{na::nbt::detail::detected_simd_level()};
+        for (auto level : {na::nbt::detail::simd_level::ssse3, na::nbt::detail::simd_level::avx2, na::nbt::detail::simd_level::avx512bw})
+        {
+            if (level > max_level)
+                break;
+            for (std::size_t bytes = 0; bytes <= 192; bytes += 8)
+            {
+                std::array<std::byte, 200> expect{}, got{};
+                na::nbt::detail::byteswap_copy_scalar<8>(expect.data(), in.data() + 1, bytes);
+                na::nbt::detail::byteswap_copy_with<8>(level, got.data(), in.data() + 1, bytes);
+                if (expect != got)
+                    return 20;
+                na::nbt::detail::byteswap_copy_scalar<2>(expect.data(), in.data() + 1, bytes + 2);
+                na::nbt::detail::byteswap_copy_with<2>(level, got.data(), in.data() + 1, bytes + 2);
+                if (expect != got)
+                    return 20;
+            }
+        }
+    }
+    {
+        // 大端模式下单字节 payload 也直接复制，三个字段合并成一个 direct copy step
+        byte_payload_test value{15, {1, 2, 3, 4, -5}, {-1, 0, 1}};
+        std::array<std::byte, 64> out{};
+        std::size_t length{};
+        na::nbt::nbt_error errc{};
+        auto ret{na::serializer::serialize<na::nbt::nbt, na::nbt::option<>>(value, std::span{out}, length, errc)};
+        byte_payload_test value2{};
+        auto ret2{na::serializer::deserialize<na::nbt::nbt, na::nbt::option<>>(value2, std::span<std::byte const>{out.data(), length}, errc)};
+        if (!ret || !ret2 || value2.light != 15 || value2.biomes != value.biomes || value2.flags != value.flags)
+            return 22;
+        using byte_node = na::serializer::node<na::nbt::nbt, na::nbt::option<>, na::serializer::serializer_profile<na::serializer::operations::serialize>, na::serializer::node_path<byte_payload_test>>;
+        using byte_steps = na::serializer::generate_serialize_step_list<byte_node, na::serializer::operations::deserialize>;
+        if (byte_steps::size != 2 || byte_steps::at<1>::size != 3)
+            return 23;
+    }
+    {
+        // 其他工具写出的文件字段顺序可能不同
+        test_type_reordered value{0.25, 4, -3, 1451};
+        std::array<std::byte, 64> out{};
+        std::size_t length{};
+        na::nbt::nbt_error errc{};
+        auto ret{na::serializer::serialize<na::nbt::nbt, na::nbt::option<>>(value, std::span{out}, length, errc)};
+        test_type value2{};
+        auto strict{na::serializer::deserialize<na::nbt::nbt, na::nbt::option<>>(value2, std::span<std::byte const>{out.data(), length}, errc)};
+        auto ret2{na::serializer::deserialize<na::nbt::nbt, na::nbt::option<std::endian::big, true>>(value2, std::span<std::byte const>{out.data(), length}, errc)};
+        if (!ret || strict || !ret2 || value2.i8 != -3 || value2.i64 != 1451 || value2.i16 != 4 || value2.dbl != 0.25)
+            return 10;
+
+        // 缺少字段时不能把快速路径留下的值当作结果
+        test_type_missing missing{0.5, 6, 2};
+        if (!na::serializer::serialize<na::nbt::nbt, na::nbt::option<>>(missing, std::span{out}, length, errc))
+            return 10;
+        test_type value3{};
+        if (na::serializer::deserialize<na::nbt::nbt, na::nbt::option<std::endian::big, true>>(value3, std::span<std::byte const>{out.data(), length}, errc) || errc != na::nbt::nbt_error::invalid)
+            return 10;
+    }
+#ifdef NA_SERIALIZER_HAS_ZLIB
+    {
+        // gzip 与 zlib 输入共用一个解压器，缓冲区在多次调用之间复用
+        bulk_array_test value{};
+        for (int i = 0; i < 37; i++)
+        {
+            value.longs[i] = 0x0102030405060708LL * (i + 1);
+            value.shorts[i] = static_cast<std::int16_t>(i);
+            value.ints.push_back(i * 3);
+            value.floats.push_back(0.25f * i);
+        }
+        std::array<std::byte, 1024> raw{};
+        std::size_t length{};
+        na::nbt::nbt_error errc{};
+        if (!na::serializer::serialize<na::nbt::nbt, na::nbt::option<>>(value, std::span{raw}, length, errc))
+            return 31;
+        auto const compress{[&](int window_bits, std::span<std::byte> input) {
+            std::vector<std::byte> out(1024);
+            z_stream stream{};
+            deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY);
+            stream.next_in = reinterpret_cast<Bytef*>(input.data());
+            stream.avail_in = static_cast<uInt>(input.size());
+            stream.next_out = reinterpret_cast<Bytef*>(out.data());
+            stream.avail_out = static_cast<uInt>(out.size());
+            deflate(&stream, Z_FINISH);
+            out.resize(stream.total_out);
+            deflateEnd(&stream);
+            return out;
+        }};
+        auto const gzip{compress(15 + 16, std::span{raw}.first(length))};
+        auto const zlib{compress(15, std::span{raw}.first(length))};
+        if (na::nbt::detect_compression(gzip) != na::nbt::compression::gzip || na::nbt::detect_compression(zlib) != na::nbt::compression::zlib || na::nbt::detect_compression(std::span{raw}.first(length)) != na::nbt::compression::none)
+            return 31;
+        na::nbt::inflater inflater{};
+        for (auto const* input : {&gzip, &zlib, &gzip})
+        {
+            bulk_array_test value2{};
+            if (!na::nbt::deserialize_compressed(value2, std::span{*input}, inflater, errc) || value2.longs != value.longs || value2.floats != value.floats)
+                return 31;
+        }
+        // gzip 按 ISIZE 一次分配到位
+        if (inflater.capacity() != length + 1)
+            return 31;
+
+        // 压缩输出直接来自分段序列化，解压后与普通序列化结果一致
+        for (auto format : {na::nbt::compression::gzip, na::nbt::compression::zlib, na::nbt::compression::none})
+        {
+            na::nbt::deflater deflater{format, na::nbt::deflater::fast_level, 64, 32};
+            na::serializer::memory_builder<> compressed{};
+            for (int round = 0; round < 2; round++)
+            {
+                compressed.clear();
+                if (!na::nbt::serialize_compressed(value, deflater, compressed, errc))
+                    return 33;
+            }
+            std::vector<std::byte> joined(compressed.size());
+            compressed.copy_to(joined.data());
+            bulk_array_test value2{};
+            if (na::nbt::detect_compression(joined) != (format == na::nbt::compression::none ? na::nbt::compression::none : format) || !na::nbt::deserialize_compressed(value2, std::span{joined}, inflater, errc) || value2.longs != value.longs || value2.ints != value.ints || value2.floats != value.floats)
+                return 33;
+        }
+        std::span<std::byte const> inflated{};
+        // 截断的输入是 end_of_file，损坏的输入是 invalid
+        if (inflater.decompress(std::span{gzip}.first(gzip.size() - 20), inflated, errc) || errc != na::nbt::nbt_error::end_of_file)
+            return 32;
+        auto bad{zlib};
+        bad[bad.size() / 2] ^= std::byte{0x55};
+        if (inflater.decompress(std::span{bad}, inflated, errc) || errc != na::nbt::nbt_error::invalid)
+            return 32;
+
+        // 多成员 gzip 依次解压并拼接
+        auto members{compress(15 + 16, std::span{raw}.first(10))};
+        auto const second{compress(15 + 16, std::span{raw}.first(length).subspan(10))};
+        members.insert(members.end(), second.begin(), second.end());
+        if (!inflater.decompress(std::span{members}, inflated, errc) || inflated.size() != length || std::memcmp(inflated.data(), raw.data(), length) != 0)
+            return 32;
+        // gzip 或 zlib 流之后多出的字节是 invalid
+        for (auto const* input : {&gzip, &zlib})
+        {
+            auto trailing{*input};
+            trailing.insert(trailing.end(), {std::byte{0x00}, std::byte{0x12}, std::byte{0x34}});
+            errc = na::nbt::nbt_error::ok;
+            if (inflater.decompress(std::span{trailing}, inflated, errc) || errc != na::nbt::nbt_error::invalid)
+                return 32;
+        }
+    }
+#endif
+    {
+        // 手工构造 region 文件：(0, 0) 未压缩，(3, 1) 用 zlib 压缩，(31, 31) 越界
+        test_type value{-3, 1451, 4, 0.25};
+        std::array<std::byte, 64> raw{};
+        std::size_t length{};
+        na::nbt::nbt_error errc{};
+        if (!na::serializer::serialize<na::nbt::nbt, na::nbt::option<>>(value, std::span{raw}, length, errc))
+            return 35;
+        std::vector<std::byte> file(na::nbt::region::header_size + 2 * na::nbt::region::sector_size);
+        auto const put{[&](std::size_t pos, std::uint32_t v) {
+            for (int i = 0; i < 4; i++)
+                file[pos + i] = static_cast<std::byte>(v >> (24 - 8 * i));
+        }};
+        auto const store{[&](std::size_t index, std::uint32_t sector, std::span<std::byte const> data, na::nbt::compression type) {
+            put(index * 4, na::nbt::region::encode_location({sector, 1}));
+            put(na::nbt::region::sector_size + index * 4, 1700000000 + static_cast<std::uint32_t>(index));
+            put(sector * na::nbt::region::sector_size, static_cast<std::uint32_t>(data.size() + 1));
+            file[sector * na::nbt::region::sector_size + 4] = static_cast<std::byte>(type);
+            std::memcpy(file.data() + sector * na::nbt::region::sector_size + 5, data.data(), data.size());
+        }};
+        store(na::nbt::region::chunk_index(0, 0), 2, std::span{raw}.first(length), na::nbt::compression::none);
+#ifdef NA_SERIALIZER_HAS_ZLIB
+        std::vector<std::byte> compressed(128);
+        auto compressed_size{static_cast<uLongf>(compressed.size())};
+        compress(reinterpret_cast<Bytef*>(compressed.data()), &compressed_size, reinterpret_cast<Bytef const*>(raw.data()), static_cast<uLong>(length));
+        store(na::nbt::region::chunk_index(-29, 33), 3, std::span{compressed}.first(compressed_size), na::nbt::compression::zlib);
+#endif
+        put(na::nbt::region::chunk_index(31, 31) * 4, na::nbt::region::encode_location({9, 1}));
+        char const* path{"na_serializer_region_test.mca"};
+        auto* out{std::fopen(path, "wb")};
+        if (out == nullptr || std::fwrite(file.data(), 1, file.size(), out) != file.size())
+            return 35;
+        std::fclose(out);
+
+        na::nbt::region::reader region{};
+        if (!region.open(path, errc) || !region.contains(0, 0) || region.contains(1, 0))
+            return 35;
+        std::remove(path);
+        na::nbt::region::chunk_span chunk{};
+        if (!region.chunk(32, -32, chunk, errc) || chunk.type != na::nbt::compression::none || chunk.timestamp != 1700000000 || chunk.data.size() != length || chunk.data.data() != region.bytes().data() + 2 * na::nbt::region::sector_size + 5)
+            return 35;
+        test_type value2{};
+        if (!na::nbt::region::read_chunk(region, 0, 0, value2, na::nbt::region::no_decompressor{}, errc) || value2.i64 != 1451 || value2.dbl != 0.25)
+            return 35;
+        errc = na::nbt::nbt_error::invalid;
+        if (region.chunk(1, 0, chunk, errc) || errc != na::nbt::nbt_error::ok)
+            return 36;
+        if (region.chunk(31, 31, chunk, errc) || errc != na::nbt::nbt_error::invalid)
+            return 36;
+#ifdef NA_SERIALIZER_HAS_ZLIB
+        na::nbt::inflater inflater{};
+        test_type value3{};
+        if (!region.chunk(3, 1, chunk, errc) || chunk.type != na::nbt::compression::zlib || !na::nbt::region::read_chunk(region, 3, 1, value3, inflater, errc) || value3.i16 != 4 || value3.i8 != -3)
+            return 36;
+#endif
+        na::nbt::region::reader missing{};
+        if (missing.open("na_serializer_region_missing.mca", errc) || missing.is_open())
+            return 36;
+    }
+    {
+        // 写入端：原地覆盖、扇区搬移、flush 后复用被释放的扇区，表头只写回改动的范围
+        char const* path{"na_serializer_region_write_test.mca"};
+        std::remove(path);
+        na::nbt::nbt_error errc{};
+        std::vector<std::byte> small(100, std::byte{0x11});
+        std::vector<std::byte> large(5000, std::byte{0x22});
+        na::nbt::region::writer writer{};
+        if (!writer.open(path, errc) || writer.sectors() != 2)
+            return 37;
+        if (!writer.write(0, 0, std::span{small}, na::nbt::compression::none, 7, errc) || !writer.write(1, 0, std::span{small}, na::nbt::compression::zlib, 8, errc))
+            return 37;
+        if (writer.dirty_bytes() != 16 || writer.location(0).sector_offset != 2 || writer.location(1).sector_offset != 3)
+            return 37;
+        if (!writer.flush(false, errc) || writer.dirty_bytes() != 0)
+            return 37;
+        small[0] = std::byte{0x33};
+        if (!writer.write(0, 0, std::span{small}, na::nbt::compression::none, 9, errc) || writer.location(0).sector_offset != 2 || writer.dirty_bytes() != 8)
+            return 38;
+        // 扇区 2 在 flush 之前不会被复用
+        if (!writer.write(0, 0, std::span{large}, na::nbt::compression::none, 10, errc) || writer.location(0).sector_offset != 4 || writer.location(0).sector_count != 2)
+            return 38;
+        if (!writer.flush(true, errc))
+            return 38;
+        test_type value{-3, 1451, 4, 0.25};
+        na::serializer::memory_builder<16> scratch{};
+        if (!na::nbt::region::write_chunk(writer, 2, 0, value, 11, scratch, errc) || writer.location(2).sector_offset != 2 || writer.sectors() != 6)
+            return 38;
+        if (!writer.erase(1, errc) || !writer.close())
+            return 38;
+
+        na::nbt::region::reader region{};
+        na::nbt::region::chunk_span chunk{};
+        if (!region.open(path, errc) || region.bytes().size() != 6 * na::nbt::region::sector_size || region.contains(1, 0))
+            return 39;
+        if (!region.chunk(0, 0, chunk, errc) || chunk.timestamp != 10 || chunk.data.size() != large.size() || !std::equal(chunk.data.begin(), chunk.data.end(), large.begin()))
+            return 39;
+        test_type value2{};
+        if (!na::nbt::region::read_chunk(region, 2, 0, value2, na::nbt::region::no_decompressor{}, errc) || value2.i64 != 1451 || value2.dbl != 0.25)
+            return 39;
+        region.close();
+
+        // 重新打开后扇区占用表由位置表重建，扇区 3 已被释放
+        if (!writer.open(path, errc) || !writer.write(5, 5, std::span{small}, na::nbt::compression::none, 12, errc) || writer.location(na::nbt::region::chunk_index(5, 5)).sector_offset != 3)
+            return 39;
+        writer.close();
+        std::remove(path);
+
+        // 段数超过一次 pwritev 的批量时分批写出，数据按顺序落盘
+        {
+            std::vector<std::byte> payload(200 * 37);
+            for (std::size_t i = 0; i < payload.size(); i++)
+                payload[i] = static_cast<std::byte>(i * 7 + i / 37);
+            std::vector<::iovec> pieces{};
+            for (std::size_t i = 0; i < 200; i++)
+                pieces.push_back(::iovec{payload.data() + i * 37, i % 50 == 0 ? std::size_t{0} : std::size_t{37}});
+            std::size_t length{0};
+            for (auto const& piece : pieces)
+                length += piece.iov_len;
+            std::vector<std::byte> expect{};
+            for (auto const& piece : pieces)
+                expect.insert(expect.end(), static_cast<std::byte*>(piece.iov_base), static_cast<std::byte*>(piece.iov_base) + piece.iov_len);
+            if (!writer.open(path, errc) || !writer.write(7, pieces, length, na::nbt::compression::none, 3, errc) || !writer.close())
+                return 39;
+            if (!region.open(path, errc) || !region.chunk(7, 0, chunk, errc) || chunk.data.size() != expect.size() || !std::equal(chunk.data.begin(), chunk.data.end(), expect.begin()))
+                return 39;
+            region.close();
+            std::remove(path);
+        }
+
+        // 位置表项损坏（指向表头、与其他 chunk 重叠）时不原地覆盖，表头与其他 chunk 的数据保持完整
+        if (!writer.open(path, errc) || !writer.write(0, small, na::nbt::compression::none, 1, errc) || !writer.write(1, small, na::nbt::compression::none, 2, errc) || !writer.close())
+            return 52;
+        if (auto const file{std::fopen(path, "r+b")}; file != nullptr)
+        {
+            std::array<std::byte, 4> entry{};
+            na::nbt::endian_set<std::uint32_t, std::endian::big>(entry.data(), na::nbt::region::encode_location({0, 1}));
+            std::fseek(file, 5 * 4, SEEK_SET);
+            std::fwrite(entry.data(), 1, entry.size(), file);
+            na::nbt::endian_set<std::uint32_t, std::endian::big>(entry.data(), na::nbt::region::encode_location({3, 1}));
+            std::fseek(file, 6 * 4, SEEK_SET);
+            std::fwrite(entry.data(), 1, entry.size(), file);
+            std::fclose(file);
+        }
+        if (!writer.open(path, errc) || writer.corrupt(0) || !writer.corrupt(1) || !writer.corrupt(5) || !writer.corrupt(6))
+            return 52;
+        std::vector<std::byte> other(200, std::byte{0x44});
+        if (!writer.write(5, other, na::nbt::compression::none, 3, errc) || !writer.write(6, other, na::nbt::compression::none, 4, errc) || !writer.write(1, other, na::nbt::compression::none, 5, errc))
+            return 52;
+        if (writer.location(5).sector_offset < 4 || writer.location(6).sector_offset < 4 || writer.location(1).sector_offset < 4 || writer.corrupt(1) || !writer.close())
+            return 52;
+        if (!region.open(path, errc))
+            return 52;
+        for (std::size_t index : {0, 1, 5, 6})
+        {
+            auto const& expect{index == 0 ? small : other};
+            if (!region.chunk(index, chunk, errc) || !std::equal(chunk.data.begin(), chunk.data.end(), expect.begin(), expect.end()))
+                return 52;
+        }
+        region.close();
+        std::remove(path);
+    }
+    {
+        // 并行扫描：每个 region 文件写入若干 chunk，其中一个损坏，另有一个不是 region 的文件
+        std::filesystem::path const directory{"na_serializer_scan_test"};
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directory(directory);
+        na::nbt::nbt_error errc{};
+        na::serializer::memory_builder<64> scratch{};
+        std::int64_t expected{0};
+        for (auto [rx, rz, count] : {std::tuple{0, 0, 40}, std::tuple{-1, 2, 3}, std::tuple{1, 1, 17}, std::tuple{5, -5, 1}})
+        {
+            na::nbt::region::writer writer{};
+            if (!writer.open((directory / ("r." + std::to_string(rx) + "." + std::to_string(rz) + ".mca")).c_str(), errc))
+                return 40;
+            for (int i = 0; i < count; i++)
+            {
+                // i64 记录世界坐标，回调据此校验坐标换算
+                test_type value{static_cast<std::int8_t>(i), (rx * 32 + i % 32) * 1000LL + (rz * 32 + i / 32), 4, 0.5};
+                expected += value.i64;
+                if (!na::nbt::region::write_chunk(writer, i % 32, i / 32, value, 1, scratch, errc))
+                    return 40;
+            }
+            if (rx == 1)
+            {
+                std::vector<std::byte> garbage(16, std::byte{0x7F});
+                if (!writer.write(31, 31, std::span{garbage}, na::nbt::compression::none, 1, errc))
+                    return 40;
+            }
+            if (!writer.close())
+                return 40;
+        }
+        auto* broken{std::fopen((directory / "r.9.9.mca").c_str(), "wb")};
+        std::fputs("short", broken);
+        std::fclose(broken);
+
+        std::atomic<std::int64_t> sum{0};
+        std::atomic<std::size_t> failed{0};
+        std::atomic<bool> mismatch{false};
+        auto const stats{na::nbt::region::scan<test_type>(
+            directory,
+            [&](na::nbt::region::scan_chunk const& info, test_type const& value, na::nbt::nbt_error error_code) {
+                if (error_code != na::nbt::nbt_error::ok)
+                {
+                    failed++;
+                    return;
+                }
+                if (value.i64 != info.x * 1000LL + info.z || info.timestamp != 1)
+                    mismatch = true;
+                sum += value.i64;
+            },
+            na::nbt::region::scan_options{.threads = 3})};
+        if (stats.files != 5 || stats.failed_files != 1 || stats.chunks != 61 || stats.failed_chunks != 1 || failed != 1 || mismatch || sum != expected)
+            return 41;
+
+        // 回调返回 false 时所有线程停止
+        std::atomic<std::size_t> seen{0};
+        auto const stopped{na::nbt::region::scan<test_type>(
+            directory,
+            [&](na::nbt::region::scan_chunk const&, test_type const&, na::nbt::nbt_error) {
+                return ++seen < 5;
+            },
+            na::nbt::region::scan_options{.threads = 2})};
+        if (stopped.chunks + stopped.failed_chunks >= 61 || seen < 5)
+            return 41;
+        std::filesystem::remove_all(directory);
+    }
+    {
+        // 流水线：队列深度 4 远小于请求数，覆盖背压与缓冲区回收；结果按提交顺序到达
+        char const* path{"na_serializer_pipeline_test.mca"};
+        std::remove(path);
+        na::nbt::nbt_error errc{};
+        {
+            na::nbt::region::writer writer{};
+            na::serializer::memory_builder<64> scratch{};
+            if (!writer.open(path, errc))
+                return 42;
+            for (int i = 0; i < 20; i++)
+            {
+                test_type value{static_cast<std::int8_t>(i), i * 7LL, 4, 0.5};
+#ifdef NA_SERIALIZER_HAS_ZLIB
+                if (i % 2 == 1)
+                {
+                    na::nbt::deflater deflater{na::nbt::compression::zlib};
+                    na::serializer::memory_builder<64> compressed{};
+                    std::vector<std::byte> joined{};
+                    if (!na::nbt::serialize_compressed(value, deflater, compressed, errc))
+                        return 42;
+                    joined.resize(compressed.size());
+                    compressed.copy_to(joined.data());
+                    if (!writer.write(static_cast<std::size_t>(i), std::span{joined}, na::nbt::compression::zlib, 1, errc))
+                        return 42;
+                    continue;
+                }
+#endif
+                if (!na::nbt::region::write_chunk(writer, i, 0, value, 1, scratch, errc))
+                    return 42;
+            }
+            std::vector<std::byte> garbage(16, std::byte{0x7F});
+            if (!writer.write(std::size_t{20}, std::span{garbage}, na::nbt::compression::none, 1, errc) || !writer.close())
+                return 42;
+        }
+        na::nbt::region::reader region{};
+        if (!region.open(path, errc))
+            return 42;
+        std::remove(path);
+        std::int64_t sum{0};
+        std::uint64_t next_tag{0};
+        std::size_t missing{0};
+        std::size_t invalid{0};
+        bool ordered{true};
+        {
+            na::nbt::region::pipeline<test_type, na::nbt::option<>, na::nbt::region::default_decompressor, 4> pipeline{[&](na::nbt::region::chunk_request const& request, test_type& value, na::nbt::nbt_error error_code) {
+                ordered = ordered && request.tag == next_tag++;
+                if (error_code == na::nbt::nbt_error::end_of_file)
+                    missing++;
+                else if (error_code != na::nbt::nbt_error::ok)
+                    invalid++;
+                else if (value.i64 != static_cast<std::int64_t>(request.index) * 7)
+                    ordered = false;
+                else
+                    sum += value.i64;
+            }};
+            for (std::uint64_t tag = 0; tag < 300; tag++)
+                pipeline.submit(na::nbt::region::chunk_request{&region, static_cast<std::size_t>(tag % 25), tag});
+        }
+        // 每 25 个请求中 20 个有效、1 个损坏、4 个不存在
+        if (!ordered || next_tag != 300 || sum != 12 * 7 * 190 || invalid != 12 || missing != 48)
+            return 43;
+
+        // 已读入内存的扇区：100 次提交只循环使用 4 个扇区缓冲区，缓冲区不归还时会阻塞在第 5 次提交
+        std::vector<std::vector<std::byte>> sectors(20);
+        for (std::size_t index = 0; index < sectors.size(); index++)
+        {
+            na::nbt::region::chunk_span chunk{};
+            if (!region.chunk(index, chunk, errc))
+                return 43;
+            auto& copy{sectors[index]};
+            copy.resize(5 + chunk.data.size());
+            na::nbt::endian_set<std::uint32_t, std::endian::big>(copy.data(), static_cast<std::uint32_t>(chunk.data.size() + 1));
+            copy[4] = static_cast<std::byte>(chunk.type);
+            std::memcpy(copy.data() + 5, chunk.data.data(), chunk.data.size());
+        }
+        sum = 0;
+        next_tag = 0;
+        {
+            na::nbt::region::pipeline<test_type, na::nbt::option<>, na::nbt::region::default_decompressor, 4> pipeline{[&](na::nbt::region::chunk_request const& request, test_type& value, na::nbt::nbt_error error_code) {
+                ordered = ordered && request.tag == next_tag++ && error_code == na::nbt::nbt_error::ok && value.i64 == static_cast<std::int64_t>(request.tag % 20) * 7;
+                sum += value.i64;
+            }};
+            for (std::uint64_t tag = 0; tag < 100; tag++)
+                pipeline.submit_sectors(na::nbt::region::chunk_request{nullptr, 0, tag}, sectors[tag % 20], na::nbt::nbt_error::ok);
+        }
+        if (!ordered || next_tag != 100 || sum != 5 * 7 * 190)
+            return 43;
+    }
+#ifdef __linux__
+    {
+        // io_uring 批量读取；内核不支持或被禁止时跳过
+        na::nbt::nbt_error errc{};
+        na::nbt::uring_reader uring{};
+        if (uring.open(2, 4096, errc))
+        {
+            std::vector<std::string> names{};
+            test_type value{-3, 1451, 4, 0.25};
+            std::array<std::byte, 64> raw{};
+            std::size_t length{};
+            if (!na::serializer::serialize<na::nbt::nbt, na::nbt::option<>>(value, std::span{raw}, length, errc))
+                return 44;
+            // 五个文件分三批读完；第四个被截断，第五个大于缓冲区
+            for (int i = 0; i < 5; i++)
+            {
+                names.push_back("na_serializer_uring_test_" + std::to_string(i) + ".dat");
+                auto* out{std::fopen(names.back().c_str(), "wb")};
+                value.i64 = 1000 + i;
+                if (!na::serializer::serialize<na::nbt::nbt, na::nbt::option<>>(value, std::span{raw}, length, errc))
+                    return 44;
+                if (i == 4)
+                {
+                    std::vector<std::byte> large(8192);
+                    std::fwrite(large.data(), 1, large.size(), out);
+                }
+                else
+                {
+                    std::fwrite(raw.data(), 1, i == 3 ? length - 3 : length, out);
+                }
+                std::fclose(out);
+            }
+            std::vector<char const*> paths{};
+            for (auto const& name : names)
+                paths.push_back(name.c_str());
+            paths.push_back("na_serializer_uring_missing.dat");
+            std::vector<int> results(paths.size(), -1);
+            if (!na::nbt::load_documents<test_type>(uring, paths, [&](std::size_t index, test_type const& value, na::nbt::nbt_error error_code) {
+                    results[index] = error_code == na::nbt::nbt_error::ok ? static_cast<int>(value.i64) : -static_cast<int>(error_code) - 10;
+                }))
+                return 44;
+            if (results[0] != 1000 || results[1] != 1001 || results[2] != 1002 || results[3] >= 0 || results[4] != -static_cast<int>(na::nbt::nbt_error::invalid) - 10 || results[5] != -static_cast<int>(na::nbt::nbt_error::invalid) - 10)
+                return 45;
+
+            // 直接读取超出文件末尾的范围：得到实际长度与 end_of_file
+            auto const fd{::open(paths[0], O_RDONLY)};
+            na::nbt::read_request const requests[]{{fd, 0, 4096, 7}, {fd, 2, 3, 8}, {fd, 0, 8192, 9}};
+            std::size_t seen{0};
+            if (!uring.read_batch(requests, [&](na::nbt::read_request const& request, std::span<std::byte> data, na::nbt::nbt_error error_code) {
+                    if (request.tag == 7 && error_code == na::nbt::nbt_error::end_of_file && data.size() == length && std::memcmp(data.data(), raw.data(), 4) == 0)
+                        seen++;
+                    if (request.tag == 8 && error_code == na::nbt::nbt_error::ok && data.size() == 3 && data[0] == raw[2])
+                        seen++;
+                    if (request.tag == 9 && error_code == na::nbt::nbt_error::invalid && data.empty())
+                        seen++;
+                }) || seen != 3)
+                return 45;
+
+            // 记录实际走的路径：注册成功时全部是 READ_FIXED，否则全部是 READ
+            if (uring.registered() ? (uring.fixed_reads() == 0 || uring.plain_reads() != 0) : (uring.fixed_reads() != 0 || uring.plain_reads() == 0))
+                return 54;
+            // 不注册固定缓冲区时走 IORING_OP_READ，结果相同
+            na::nbt::uring_reader plain{};
+            na::nbt::read_request const whole[]{{fd, 0, static_cast<std::uint32_t>(length), 1}};
+            std::size_t plain_seen{0};
+            if (!plain.open(2, 4096, false, errc) || plain.registered())
+                return 54;
+            if (!plain.read_batch(whole, [&](na::nbt::read_request const&, std::span<std::byte> data, na::nbt::nbt_error error_code) {
+                    if (error_code == na::nbt::nbt_error::ok && data.size() == length && std::memcmp(data.data(), raw.data(), 4) == 0)
+                        plain_seen++;
+                }) || plain_seen != 1 || plain.fixed_reads() != 0 || plain.plain_reads() == 0)
+                return 54;
+            ::close(fd);
+            for (auto const& name : names)
+                std::remove(name.c_str());
+
+            // region chunk 的扇区由 io_uring 读入后交给流水线解压与反序列化；指向表头的请求得到 invalid
+            char const* region_path{"na_serializer_uring_region.mca"};
+            std::remove(region_path);
+            na::nbt::region::writer writer{};
+            na::serializer::memory_builder<16> scratch{};
+            if (!writer.open(region_path, errc))
+                return 55;
+            for (int i = 0; i < 5; i++)
+            {
+                value.i64 = 2000 + i;
+                if (!na::nbt::region::write_chunk(writer, i, 0, value, 1, scratch, errc))
+                    return 55;
+            }
+            auto const region_fd{::open(region_path, O_RDONLY)};
+            std::vector<na::nbt::read_request> chunk_requests{};
+            for (int i = 0; i < 5; i++)
+                chunk_requests.push_back(na::nbt::chunk_read_request(region_fd, writer.location(na::nbt::region::chunk_index(i, 0)), i));
+            chunk_requests.push_back(na::nbt::chunk_read_request(region_fd, {0, 1}, 5));
+            writer.close();
+            std::vector<int> chunk_results(chunk_requests.size(), -1);
+            {
+                na::nbt::region::pipeline<test_type, na::nbt::option<>, na::nbt::region::default_decompressor, 4> pipeline{[&](na::nbt::region::chunk_request const& request, test_type& value, na::nbt::nbt_error error_code) {
+                    chunk_results[request.tag] = error_code == na::nbt::nbt_error::ok && request.file == nullptr ? static_cast<int>(value.i64) : -static_cast<int>(error_code) - 10;
+                }};
+                if (!na::nbt::read_chunks(uring, chunk_requests, pipeline))
+                    return 55;
+            }
+            for (int i = 0; i < 5; i++)
+            {
+                if (chunk_results[i] != 2000 + i)
+                    return 55;
+            }
+            if (chunk_results[5] != -static_cast<int>(na::nbt::nbt_error::invalid) - 10)
+                return 55;
+            ::close(region_fd);
+            std::remove(region_path);
+        }
+    }
+#endif
+    {
+        // 37 条首尾相接的同构记录，批量解码与逐条解码结果一致；37 不是 8/16 的倍数，覆盖向量与尾部两条路径
+        auto check{[]<typename Option>(Option) {
+            constexpr auto stride{na::nbt::record_size<test_type, Option>};
+            std::vector<test_type> values(37);
+            std::vector<std::byte> input(stride * values.size());
+            na::nbt::nbt_error errc{};
+            for (std::size_t i = 0; i < values.size(); i++)
+            {
+                values[i] = test_type{static_cast<std::int8_t>(i - 18), static_cast<std::int64_t>(i) * 0x0102030405LL - 7, static_cast<std::int16_t>(i * 311), static_cast<double>(i) * 1.25 - 3};
+                std::size_t length{};
+                if (!na::serializer::serialize<na::nbt::nbt, Option>(values[i], std::span{input.data() + i * stride, stride}, length, errc) || length != stride)
+                    return false;
+            }
+            std::vector<test_type> got(values.size());
+            std::size_t consumed{};
+            if (!na::nbt::deserialize_batch<Option>(std::span{got}, std::span<std::byte const>{input}, consumed, errc) || consumed != input.size())
+                return false;
+            for (std::size_t i = 0; i < values.size(); i++)
+            {
+                if (got[i].i8 != values[i].i8 || got[i].i64 != values[i].i64 || got[i].i16 != values[i].i16 || got[i].dbl != values[i].dbl)
+                    return false;
+            }
+            std::vector<std::int64_t> longs(values.size());
+            std::vector<double> doubles(values.size());
+            if (!na::nbt::deserialize_column<&test_type::i64, Option>(std::span{longs}, std::span<std::byte const>{input}, consumed, errc) || !na::nbt::deserialize_column<&test_type::dbl, Option>(std::span{doubles}, std::span<std::byte const>{input}, consumed, errc))
+                return false;
+            for (std::size_t i = 0; i < values.size(); i++)
+            {
+                if (longs[i] != values[i].i64 || doubles[i] != values[i].dbl)
+                    return false;
+            }
+            return true;
+        }};
+        if (!check(na::nbt::option<>{}) || !check(na::nbt::option<std::endian::little>{}))
+            return 48;
+
+        // 含非数值字段（定长 list）的记录逐条解码该字段
+        constexpr auto stride{na::nbt::record_size<outer_subset>};
+        std::vector<std::byte> input(stride * 20);
+        na::nbt::nbt_error errc{};
+        for (std::size_t i = 0; i < 20; i++)
+        {
+            outer_subset value{};
+            value.li2 = {1.5 * i, 2.5, 3.5, -4.5 * i};
+            value.i64_8 = static_cast<std::int64_t>(i) << 40;
+            std::size_t length{};
+            if (!na::serializer::serialize<na::nbt::nbt, na::nbt::option<>>(value, std::span{input.data() + i * stride, stride}, length, errc) || length != stride)
+                return 49;
+        }
+        std::vector<outer_subset> got(20);
+        std::size_t consumed{};
+        if (!na::nbt::deserialize_batch(std::span{got}, std::span<std::byte const>{input}, consumed, errc) || got[19].li2[3] != -4.5 * 19 || got[19].li2[1] != 2.5 || got[7].i64_8 != std::int64_t{7} << 40)
+            return 49;
+
+        // 输入不足：解码能容纳的记录
+        std::vector<outer_subset> more(25);
+        if (na::nbt::deserialize_batch(std::span{more}, std::span<std::byte const>{input}, consumed, errc) || errc != na::nbt::nbt_error::end_of_file || consumed != input.size() || more[19].i64_8 != std::int64_t{19} << 40)
+            return 50;
+        // 第 13 条记录的名称被篡改：只解码之前的记录
+        input[13 * stride + 6] ^= std::byte{0x20};
+        std::vector<outer_subset> broken(20);
+        if (na::nbt::deserialize_batch(std::span{broken}, std::span<std::byte const>{input}, consumed, errc) || errc != na::nbt::nbt_error::invalid || consumed != 13 * stride || broken[12].i64_8 != std::int64_t{12} << 40 || broken[13].i64_8 != 0)
+            return 50;
+    }
+    {
+        // 当前机器支持的每个等级的 gather 都与逐个实现一致，包括输出不连续（结构体数组）的情况
+        std::array<std::byte, 1024> in{};
+        for (std::size_t i = 0; i < in.size(); i++)
+            in[i] = static_cast<std::byte>(i * 13 + 5);
+        auto const max_level{na::nbt::detail::detected_simd_level()};
+        for (auto level : {na::nbt::detail::simd_level::scalar, na::nbt::detail::simd_level::avx2, na::nbt::detail::simd_level::avx512bw})
+        {
+            if (level > max_level)
+                break;
+            for (std::size_t count = 0; count <= 40; count++)
+            {
+                for (std::size_t out_stride : {std::size_t{8}, std::size_t{24}})
+                {
+                    std::array<std::byte, 1024> expect{}, got{};
+                    na::nbt::detail::gather_column_scalar<8, true>(expect.data(), out_stride, in.data() + 3, 23, count);
+                    na::nbt::detail::gather_column_with<8, true>(level, got.data(), out_stride, in.data() + 3, 23, count);
+                    if (expect != got)
+                        return 51;
+                    expect = {};
+                    got = {};
+                    na::nbt::detail::gather_column_scalar<4, true>(expect.data(), out_stride / 2, in.data() + 1, 19, count);
+                    na::nbt::detail::gather_column_with<4, true>(level, got.data(), out_stride / 2, in.data() + 1, 19, count);
+                    if (expect != got)
+                        return 51;
+                    expect = {};
+                    got = {};
+                    na::nbt::detail::gather_column_scalar<4, false>(expect.data(), 4, in.data(), 11, count);
+                    na::nbt::detail::gather_column_with<4, false>(level, got.data(), 4, in.data(), 11, count);
+                    if (expect != got)
+                        return 51;
+                    expect = {};
+                    got = {};
+                    na::nbt::detail::gather_column_scalar<2, true>(expect.data(), out_stride / 4, in.data() + 2, 17, count);
+                    na::nbt::detail::gather_column_with<2, true>(level, got.data(), out_stride / 4, in.data() + 2, 17, count);
+                    if (expect != got)
+                        return 51;
+                }
+            }
+        }
+    }
+    {
+        // 被移走的缓冲区容量归零，reserve 重新分配
+        na::nbt::decompress_buffer buffer{};
+        if (!buffer.reserve(64, 0) || buffer.capacity != 64)
+            return 53;
+        auto moved{std::move(buffer)};
+        if (moved.capacity != 64 || buffer.capacity != 0 || !buffer.reserve(32, 0) || buffer.data == nullptr || buffer.capacity != 32)
+            return 53;
+        buffer = std::move(moved);
+        if (buffer.capacity != 64 || moved.capacity != 0 || !moved.reserve(16, 0) || moved.data == nullptr)
+            return 53;
     }
 }
\ No newline at end of file